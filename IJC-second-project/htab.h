@@ -14,7 +14,15 @@ typedef struct htab htab_t;     // typedef podle zadání
 
 // Typy:
 typedef const char * htab_key_t;        // typ klíče
+#ifdef HTAB_VALUE_64
+// 64bitová hodnota (čítače nepřetečou, vejde se i ukazatel přes intptr_t),
+// knihovna i program musí být přeloženy se stejným nastavením
+typedef long long htab_value_t;         // typ hodnoty
+#define HTAB_VALUE_FMT "lld"            // formát pro printf
+#else
 typedef int htab_value_t;               // typ hodnoty
+#define HTAB_VALUE_FMT "d"              // formát pro printf
+#endif
 
 // Dvojice dat v tabulce:
 typedef struct htab_pair {
@@ -25,6 +33,10 @@ typedef struct htab_pair {
 // Rozptylovací (hash) funkce (stejná pro všechny tabulky v programu)
 // Pokud si v programu definujete stejnou funkci, použije se ta vaše.
 size_t htab_hash_function(htab_key_t str);
+// Varianta pro klíč zadaný ukazatelem a délkou (nemusí končit '\0').
+// Musí vracet stejnou hodnotu jako htab_hash_function pro tentýž řetězec,
+// pokud předefinujete jednu z nich, předefinujte i druhou.
+size_t htab_hash_function_n(const char *str, size_t len);
 
 // Funkce pro práci s tabulkou:
 htab_t *htab_init(const size_t n);              // konstruktor tabulky
@@ -36,14 +48,146 @@ htab_pair_t * htab_lookup_add(htab_t * t, htab_key_t key);
 
 bool htab_erase(htab_t * t, htab_key_t key);    // ruší zadaný záznam
 
+// Hromadné rušení jedním průchodem přes seznamy: htab_erase_if zruší záznamy,
+// pro které pred vrátí true, htab_retain naopak ponechá jen ty s true.
+// Zrušené záznamy se vyjmou přímo ze seznamů bez nového hashování klíčů, jejich místa
+// použijí další vložené záznamy. Zbylé záznamy se nepřesouvají, ukazatele na ně platí dál.
+// Vrací počet zrušených.
+size_t htab_erase_if(htab_t * t, bool (*pred)(htab_pair_t *data, void *ctx), void *ctx);
+size_t htab_retain(htab_t * t, bool (*pred)(htab_pair_t *data, void *ctx), void *ctx);
+
+// Varianty s klíčem (ptr, len) -- klíč nemusí být ukončen '\0', takže lze
+// hledat přímo ve vstupním bufferu; kopie klíče vzniká jen při vložení.
+htab_pair_t * htab_find_n(const htab_t * t, const char *key, size_t len);
+htab_pair_t * htab_lookup_add_n(htab_t * t, const char *key, size_t len);
+bool htab_erase_n(htab_t * t, const char *key, size_t len);
+
+// Klíč složený z částí oddělených znakem sep (např. n-gram slov): hledá se porovnáním
+// po částech a spojený klíč vzniká jen při vložení nového záznamu, hodnotu zvýší jako
+// htab_lookup_add. hash je hash spojeného klíče, htab_hash_append ho spočítá z hashů částí:
+// h(a sep b) = (h(a)*65599 + sep)*65599^len(b) + h(b), stejně jako htab_hash_function_n.
+size_t htab_hash_append(size_t hash, char sep, size_t part_hash, size_t part_len);
+htab_pair_t * htab_lookup_add_parts(htab_t * t, size_t hash, const char *const *parts, const size_t *lens,
+                                    size_t n, char sep);
+
+// Vložení nebo úprava jedním průchodem seznamem:
+// htab_lookup_insert_n vrátí nalezený záznam, nebo vytvoří nový s hodnotou 0
+// a nastaví *created, úpravu hodnoty pak provede volající sám.
+// htab_upsert zavolá init na nový záznam, nebo update na nalezený (ctx předá dál).
+htab_pair_t * htab_lookup_insert_n(htab_t * t, const char *key, size_t len, bool *created);
+htab_pair_t * htab_upsert(htab_t * t, const char *key, size_t len,
+                          void (*init)(htab_pair_t *data, void *ctx),
+                          void (*update)(htab_pair_t *data, void *ctx), void *ctx);
+
+// Sloučení tabulek: záznamy src přidá do dst, hodnoty společných klíčů sečte.
+// src se nemění (snímek i zmrazená tabulka se čtou na místě),
+// při chybě alokace vrací false a v dst je jen část záznamů.
+bool htab_merge(htab_t * dst, const htab_t * src);
+
+// Dávkové varianty: nejdříve spočítají hash všech klíčů a přednačtou jejich
+// seznamy, teprve potom hledají, takže se čekání na paměť překrývá.
+// lens může být NULL, pak jsou klíče ukončené '\0'. Výsledky jsou v out[i].
+// htab_lookup_add_batch vrací false, pokud se některý záznam nepodařilo vytvořit.
+void htab_find_batch(const htab_t * t, const char *const *keys, const size_t *lens, size_t n, htab_pair_t **out);
+bool htab_lookup_add_batch(htab_t * t, const char *const *keys, const size_t *lens, size_t n, htab_pair_t **out);
+
 // for_each: projde všechny záznamy a zavolá na ně funkci f
+// Záznamy leží v jednom souvislém poli v pořadí vložení (nový záznam jen obsadí
+// místo dříve zrušeného), průchod je tedy sekvenční a jeho pořadí deterministické.
 // Pozor: f nesmí měnit klíč .key ani přidávat/rušit položky
 void htab_for_each(const htab_t * t, void (*f)(htab_pair_t *data));
 
+// Kurzor pro postupný průchod bez volání funkce pro každý záznam.
+// Vrací přímo záznamy v tabulce: klíč se nesmí měnit, hodnota ano.
+// Během průchodu se nesmí přidávat ani rušit položky.
+// Načtený snímek nebo zmrazenou tabulku kurzor nejdříve převede do paměti (htab_thaw),
+// proto tabulka není const; pokud převod selže, je průchod prázdný.
+typedef struct htab_iter {
+    const htab_t *t;
+    size_t slot;        // pozice v poli záznamů, kde průchod pokračuje
+    size_t end;         // pozice za koncem procházeného rozsahu
+} htab_iter_t;
+
+void htab_iter_begin(htab_t * t, htab_iter_t *it);    // celá tabulka
+// jen pozice <from, to) v poli záznamů -- více vláken může procházet disjunktní části,
+// pole má htab_slot_count pozic (včetně míst po zrušených záznamech)
+void htab_iter_range(htab_t * t, htab_iter_t *it, size_t from, size_t to);
+size_t htab_slot_count(const htab_t * t);
+htab_pair_t * htab_iter_next(htab_iter_t *it);              // NULL na konci
+// naplní pole out až n záznamy, vrací jejich počet (0 na konci)
+size_t htab_iter_next_batch(htab_iter_t *it, htab_pair_t **out, size_t n);
+
+// k záznamů s nejvyšší hodnotou do pole out (sestupně, shody podle klíče),
+// jeden průchod tabulkou a žádná paměť navíc mimo out, vrací počet záznamů.
+// Snímek nebo zmrazenou tabulku nejdříve převede do paměti (při chybě vrací 0).
+size_t htab_topk(htab_t * t, size_t k, htab_pair_t **out);
+
+// Seřazení pole záznamů (např. z htab_iter_next_batch) radix sortem:
+// HTAB_ORDER_VALUE sestupně podle hodnoty se shodami podle klíče jako htab_topk,
+// HTAB_ORDER_KEY podle klíče (pořadí strcmp). Vrací false, pokud chybí paměť.
+typedef enum htab_order {
+    HTAB_ORDER_VALUE,
+    HTAB_ORDER_KEY,
+} htab_order_t;
+
+bool htab_sort(htab_pair_t **pairs, size_t n, htab_order_t order);
+
+// Snímek tabulky v souboru:
+// htab_load soubor namapuje a zkontroluje a htab_find hledá přímo v něm, bez alokací,
+// takže více procesů sdílí jednu kopii v page cache. Soubor se nikdy nemění:
+// htab_find vrací záznam z vlastního pole tabulky, který se naplní při prvním nalezení,
+// změna hodnoty přes něj zůstane v procesu (kopie při zápisu po záznamech) a záznam
+// platí, dokud se tabulka nepřevede do paměti. Stávající klíče mění htab_lookup_add
+// také na místě, htab_save zapíše aktuální hodnoty.
+// htab_save, htab_merge, htab_for_each a statistiky čtou snímek na místě, nový klíč,
+// rušení, kurzor a htab_topk si tabulku nejdříve převedou do paměti.
+bool htab_save(const htab_t * t, const char *path);
+htab_t *htab_load(const char *path);
+
+// Zmrazení: nad aktuálními klíči se postaví minimální perfektní hash a záznamy
+// se přesunou do kompaktního pole. htab_find pak porovná právě jeden klíč.
+// Přidání nového klíče nebo rušení záznamu tabulku zase rozmrazí.
+bool htab_freeze(htab_t * t);
+
 void htab_clear(htab_t * t);    // ruší všechny záznamy
 void htab_free(htab_t * t);     // destruktor tabulky
 
 // výpočet a tisk statistik délky seznamů (min,max,avg) do stderr:
 void htab_statistics(const htab_t * t);
 
+// Podrobné statistiky:
+#define HTAB_STATS_HISTOGRAM 16     // délky 0..14, poslední položka je 15 a více
+
+typedef struct htab_stats {
+    size_t size;                    // počet záznamů
+    size_t bucket_count;            // velikost pole
+    size_t chain_min;               // délky seznamů
+    size_t chain_max;
+    double chain_avg;
+    size_t chain_p99;               // 99 % seznamů není delších
+    size_t chain_histogram[HTAB_STATS_HISTOGRAM];   // počet seznamů dané délky
+
+    // čítače operací, počítají se jen po zapnutí htab_stats_enable, atomicky,
+    // takže htab_find může běžet ve více vláknech i se zapnutými čítači
+    unsigned long long lookups;     // find a lookup_add
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long inserts;
+    unsigned long long erases;
+    unsigned long long key_compares;    // porovnání klíčů při hledání
+    double compares_per_lookup;
+
+    // obsazená paměť v bajtech
+    size_t bucket_bytes;            // struktura tabulky a pole seznamů
+    size_t item_bytes;              // položky seznamů
+    size_t key_bytes;               // kopie klíčů
+} htab_stats_t;
+
+void htab_stats_enable(htab_t * t, bool enable);    // zapne/vypne čítače (vypnuto)
+void htab_get_stats(const htab_t * t, htab_stats_t *stats);
+
+// obsazená paměť v bajtech (součet bucket_bytes, item_bytes a key_bytes) bez
+// průchodu záznamy, takže ji lze kontrolovat po každém vložení; klíče z poolu nezahrnuje
+size_t htab_memory(const htab_t * t);
+
 #endif // HTAB_H__
\ No newline at end of file
@@ -0,0 +1,313 @@
+// htab.hpp
+// Solution IJC-DU2, task b)
+// Author: Adam Běhoun, FIT
+// Date: 17.4.2024
+// login: xbehoua00
+// Compiled: g++ (GCC) 10.5.0
+//
+// Header-only C++ version of htab with the same storage design: array of buckets,
+// each bucket is a chain of items stored in one dense chunked array (htab_item.h).
+// Unlike the C table it grows, by the load as std::unordered_map does. Hash and equality
+// are template parameters, so they are inlined instead of called through
+// a pointer, and lookups accept any type the functors accept (std::string_view
+// for std::string keys), the key is constructed only on insertion.
+
+#ifndef HTAB_HPP__ // prevent multiple includes
+#define HTAB_HPP__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace ijc {
+
+// the same function as htab_hash_function, so both libraries place strings alike
+struct htab_string_hash {
+    using is_transparent = void;
+
+    std::size_t operator()(std::string_view str) const noexcept {
+        std::uint32_t h = 0;     // has to be 32 bits
+        for (unsigned char c : str)
+            h = 65599 * h + c;
+        return h;
+    }
+};
+
+// strings use htab_string_hash, everything else std::hash
+template <class Key>
+struct htab_default_hash : std::hash<Key> {};
+template <>
+struct htab_default_hash<std::string> : htab_string_hash {};
+template <>
+struct htab_default_hash<std::string_view> : htab_string_hash {};
+
+// pair of the record, the same shape as htab_pair_t
+template <class Key, class Value>
+struct htab_pair {
+    const Key key;
+    Value value;
+};
+
+template <class Key, class Value, class Hash = htab_default_hash<Key>, class Eq = std::equal_to<>>
+class htab {
+public:
+    using pair_type = htab_pair<Key, Value>;
+
+    // n is only the initial number of buckets, the table grows with the number of records
+    explicit htab(std::size_t n = 31, const Hash &hash = Hash(), const Eq &eq = Eq())
+        : hash_(hash), eq_(eq), size_(0), arr_size_(n > 1 ? n : 1),
+          ptr_(n > 1 ? new_buckets(n) : &single_bucket_) {}
+
+    htab(const htab &) = delete;
+    htab &operator=(const htab &) = delete;
+
+    // the source is left empty with its own one bucket array, so it can still be used
+    htab(htab &&other) noexcept
+        : hash_(std::move(other.hash_)), eq_(std::move(other.eq_)) {
+        take(other);
+    }
+
+    htab &operator=(htab &&other) noexcept {
+        if (this != &other) {
+            release();
+            hash_ = std::move(other.hash_);
+            eq_ = std::move(other.eq_);
+            take(other);
+        }
+        return *this;
+    }
+
+    ~htab() { release(); }
+
+    std::size_t size() const noexcept { return size_; }
+    std::size_t bucket_count() const noexcept { return arr_size_; }
+
+    // returns the record or nullptr if the key is not in the table
+    template <class K>
+    pair_type *find(const K &key) const {
+        std::size_t hash = hash_(key);
+        for (std::uint32_t link = ptr_[hash % arr_size_]; link != 0;) {
+            item *temp = slot_item(link - 1);
+            // the cached hash rejects most of the items without touching the key
+            if (temp->hash == hash && eq_(temp->pair().key, key))
+                return &temp->pair();
+            link = temp->next;
+        }
+        return nullptr;
+    }
+
+    // returns the record, a new one with value-initialized value is created if
+    // the key is not in the table (unlike htab_lookup_add the value is not incremented)
+    template <class K>
+    pair_type *lookup_add(const K &key) {
+        std::size_t hash = hash_(key);
+        std::uint32_t *link = &ptr_[hash % arr_size_];
+        while (*link != 0) {
+            item *temp = slot_item(*link - 1);
+            if (temp->hash == hash && eq_(temp->pair().key, key))
+                return &temp->pair();
+            link = &temp->next;
+        }
+
+        // the same load as the default of std::unordered_map, one record per bucket
+        if (size_ >= arr_size_) {
+            rehash(2 * arr_size_ + 1);
+            link = &ptr_[hash % arr_size_];
+            while (*link != 0)
+                link = &slot_item(*link - 1)->next;
+        }
+
+        // appended to the end of the list as in htab_lookup_add
+        std::uint32_t slot;
+        item *new_item = new_slot(&slot);
+        new (new_item->storage) pair_type{Key(key), Value()};
+        take_slot(new_item);
+        new_item->next = 0;
+        new_item->hash = hash;
+        new_item->used = true;
+        *link = slot + 1;
+        size_++;
+        return &new_item->pair();
+    }
+
+    template <class K>
+    Value &operator[](const K &key) { return lookup_add(key)->value; }
+
+    template <class K>
+    bool erase(const K &key) {
+        std::size_t hash = hash_(key);
+        for (std::uint32_t *link = &ptr_[hash % arr_size_]; *link != 0;) {
+            std::uint32_t slot = *link - 1;
+            item *temp = slot_item(slot);
+            if (temp->hash == hash && eq_(temp->pair().key, key)) {
+                *link = temp->next;
+                free_slot(slot);
+                size_--;
+                return true;
+            }
+            link = &temp->next;
+        }
+        return false;
+    }
+
+    // f gets const pair_type &, it is a template parameter so the call is inlined.
+    // The records are passed in the order of insertion, the dense array is read sequentially.
+    template <class F>
+    void for_each(F &&f) const {
+        for (std::size_t k = 0; k < chunk_count && chunk_start(k) < used_; k++) {
+            std::size_t end = std::min<std::size_t>(chunk_capacity(k), used_ - chunk_start(k));
+            for (std::size_t i = 0; i < end; i++)
+                if (chunks_[k][i].used)
+                    f(static_cast<const pair_type &>(chunks_[k][i].pair()));
+        }
+    }
+
+    // the records are removed, the buckets are kept
+    void clear() noexcept {
+        free_items();
+        for (std::size_t i = 0; i < arr_size_; i++)
+            ptr_[i] = 0;
+    }
+
+private:
+    // The items are stored as in htab_item.h: one dense array in the order they were added,
+    // split into chunks of growing size (16, 32, 64, ... items), so they never move and the
+    // pair pointers stay valid when the table grows. The chains link the items by their
+    // slots, a bucket is the slot of its first item + 1. The key lives in the item itself,
+    // std::string keeps the short ones in its own buffer, so they need no other allocation.
+    // An erased item is not used and its slot is reused by the next new item.
+    struct item {
+        std::uint32_t next; // slot of the next item in the chain (or free item) + 1, 0 ends it
+        bool used;
+        std::size_t hash;   // growth moves the items to the new buckets without hashing the keys
+        alignas(pair_type) unsigned char storage[sizeof(pair_type)];
+
+        pair_type &pair() noexcept { return *std::launder(reinterpret_cast<pair_type *>(storage)); }
+    };
+
+    static constexpr std::size_t chunk_bits = 4;
+    static constexpr std::size_t chunk_count = 28; // almost 2^32 slots
+
+    static constexpr std::size_t chunk_start(std::size_t k) { return ((std::size_t(1) << k) - 1) << chunk_bits; }
+    static constexpr std::size_t chunk_capacity(std::size_t k) { return std::size_t(1) << (k + chunk_bits); }
+    static std::size_t slot_chunk(std::size_t slot) {
+        return 63 - __builtin_clzll((static_cast<unsigned long long>(slot) >> chunk_bits) + 1);
+    }
+
+    item *slot_item(std::size_t slot) const noexcept {
+        std::size_t k = slot_chunk(slot);
+        return &chunks_[k][slot - chunk_start(k)];
+    }
+
+    static std::uint32_t *new_buckets(std::size_t n) {
+        return new std::uint32_t[n]();
+    }
+
+    // an erased slot if there is some, otherwise the one behind the end of the dense array,
+    // the slot is taken by take_slot only after the record was constructed in it
+    item *new_slot(std::uint32_t *slot) {
+        if (free_slot_ != 0) {
+            *slot = free_slot_ - 1;
+            return slot_item(*slot);
+        }
+        std::size_t k = slot_chunk(used_);
+        if (k >= chunk_count)
+            throw std::length_error("ijc::htab: too many records");
+        if (chunks_[k] == nullptr)
+            chunks_[k] = static_cast<item *>(::operator new(chunk_capacity(k) * sizeof(item), std::align_val_t(alignof(item))));
+        *slot = used_;
+        return slot_item(*slot);
+    }
+
+    void take_slot(item *taken) noexcept {
+        if (free_slot_ != 0)
+            free_slot_ = taken->next;
+        else
+            used_++;
+    }
+
+    void free_slot(std::uint32_t slot) noexcept {
+        item *temp = slot_item(slot);
+        temp->pair().~pair_type();
+        temp->used = false;
+        temp->next = free_slot_;
+        free_slot_ = slot + 1;
+    }
+
+    // new bucket array, the cached hashes put the items to their new chains
+    void rehash(std::size_t n) {
+        std::uint32_t *buckets = new_buckets(n);
+        for (std::uint32_t slot = used_; slot-- > 0;) {
+            item *temp = slot_item(slot);
+            if (temp->used) {
+                // the slots are passed from the end, so the chains keep the order of insertion
+                std::size_t position = temp->hash % n;
+                temp->next = buckets[position];
+                buckets[position] = slot + 1;
+            }
+        }
+        if (ptr_ != &single_bucket_)
+            delete[] ptr_;
+        ptr_ = buckets;
+        arr_size_ = n;
+    }
+
+    void free_items() noexcept {
+        for (std::uint32_t slot = 0; slot < used_; slot++) {
+            item *temp = slot_item(slot);
+            if (temp->used)
+                temp->pair().~pair_type();
+        }
+        for (std::size_t k = 0; k < chunk_count; k++) {
+            if (chunks_[k] != nullptr)
+                ::operator delete(chunks_[k], std::align_val_t(alignof(item)));
+            chunks_[k] = nullptr;
+        }
+        used_ = 0;
+        free_slot_ = 0;
+        size_ = 0;
+    }
+
+    void release() noexcept {
+        free_items();
+        if (ptr_ != &single_bucket_)
+            delete[] ptr_;
+        ptr_ = &single_bucket_;
+        single_bucket_ = 0;
+        arr_size_ = 1;
+    }
+
+    // moves the records of other here, this has no records and no bucket array
+    void take(htab &other) noexcept {
+        size_ = std::exchange(other.size_, 0);
+        arr_size_ = std::exchange(other.arr_size_, 1);
+        used_ = std::exchange(other.used_, 0);
+        free_slot_ = std::exchange(other.free_slot_, 0);
+        for (std::size_t k = 0; k < chunk_count; k++)
+            chunks_[k] = std::exchange(other.chunks_[k], nullptr);
+        single_bucket_ = std::exchange(other.single_bucket_, 0);
+        ptr_ = other.ptr_ == &other.single_bucket_ ? &single_bucket_ : other.ptr_;
+        other.ptr_ = &other.single_bucket_;
+    }
+
+    Hash hash_;
+    Eq eq_;
+    std::size_t size_;
+    std::size_t arr_size_;
+    std::uint32_t *ptr_; // slot of the first item in the bucket + 1, 0 for an empty bucket
+    std::uint32_t single_bucket_ = 0; // the bucket array of an empty (or moved from) table
+    std::uint32_t used_ = 0; // slots of the dense array taken so far, erased ones included
+    std::uint32_t free_slot_ = 0; // first erased slot + 1, the others are linked by next
+    item *chunks_[chunk_count] = {};
+};
+
+} // namespace ijc
+
+#endif // HTAB_HPP__
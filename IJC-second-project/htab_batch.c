@@ -0,0 +1,160 @@
+/* htab_batch.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include "htab_struct.h"
+
+// keys are processed in groups, while one group is resolved, the first items
+// of the next group and the buckets of the group after it are being loaded
+#define HTAB_BATCH_GROUP 16
+// groups in the pipeline: hashed, items prefetched, resolved
+#define HTAB_BATCH_STAGES 3
+
+/**
+ * @brief hashes the keys of one group and prefetches their buckets
+ * 
+ * @param t hash table
+ * @param keys keys
+ * @param lens lengths of the keys or NULL for null terminated keys
+ * @param from index of the first key of the group
+ * @param to index after the last key of the group
+ * @param hashes where to store the hashes
+ * @param key_lens where to store the lengths
+ */
+static inline void batch_hash(const htab_t * t, const char *const *keys, const size_t *lens,
+                              size_t from, size_t to, size_t *hashes, size_t *key_lens) {
+    for(size_t i = from; i < to; i++) {
+        if(lens != NULL) {
+            key_lens[i - from] = lens[i];
+            hashes[i - from] = htab_hash_function_n(keys[i], lens[i]);
+        } else {
+            key_lens[i - from] = strlen(keys[i]);
+            hashes[i - from] = htab_hash_function(keys[i]);
+        }
+        __builtin_prefetch(&t->ptr[hashes[i - from] % t->arr_size]);
+    }
+}
+
+/**
+ * @brief prefetches the first items of the buckets, the buckets were prefetched
+ * one group earlier, so they should be in the cache by now. The group is resolved
+ * one group later, so the items have the time of one group to arrive.
+ * 
+ * @param t hash table
+ * @param hashes hashes of the group
+ * @param count number of keys in the group
+ */
+static inline void batch_prefetch_items(const htab_t * t, const size_t *hashes, size_t count) {
+    for(size_t i = 0; i < count; i++) {
+        const htab_item_t *head = htab_chain(t, t->ptr[hashes[i] % t->arr_size]);
+        if(head != NULL) {
+            __builtin_prefetch(head);
+        }
+    }
+}
+
+/**
+ * @brief runs the lookups in software pipeline over three groups: group g+2 is hashed
+ * and its buckets prefetched, the first items of group g+1 are prefetched and group g
+ * is resolved, so every load has the time of one whole group
+ * 
+ * @param t hash table
+ * @param keys keys
+ * @param lens lengths of the keys or NULL
+ * @param n number of keys
+ * @param out results
+ * @param add true for lookup_add, false for find
+ * @return true if all the records were found or created
+ */
+static bool batch_run(htab_t * t, const char *const *keys, const size_t *lens, size_t n, htab_pair_t **out, bool add) {
+    size_t hashes[HTAB_BATCH_STAGES][HTAB_BATCH_GROUP];
+    size_t key_lens[HTAB_BATCH_STAGES][HTAB_BATCH_GROUP];
+    size_t groups = (n + HTAB_BATCH_GROUP - 1) / HTAB_BATCH_GROUP;
+    bool ok = true;
+
+    // fill the pipeline: the first two groups are hashed, the items of the first one prefetched
+    for(size_t g = 0; g < 2 && g < groups; g++) {
+        size_t from = g * HTAB_BATCH_GROUP;
+        size_t to = from + HTAB_BATCH_GROUP < n ? from + HTAB_BATCH_GROUP : n;
+        batch_hash(t, keys, lens, from, to, hashes[g], key_lens[g]);
+    }
+    if(groups > 0) {
+        batch_prefetch_items(t, hashes[0], n < HTAB_BATCH_GROUP ? n : HTAB_BATCH_GROUP);
+    }
+
+    for(size_t g = 0; g < groups; g++) {
+        size_t from = g * HTAB_BATCH_GROUP;
+        size_t to = from + HTAB_BATCH_GROUP < n ? from + HTAB_BATCH_GROUP : n;
+        size_t *group_hashes = hashes[g % HTAB_BATCH_STAGES];
+        size_t *group_lens = key_lens[g % HTAB_BATCH_STAGES];
+
+        if(g + 2 < groups) {
+            size_t later = (g + 2) * HTAB_BATCH_GROUP;
+            size_t later_to = later + HTAB_BATCH_GROUP < n ? later + HTAB_BATCH_GROUP : n;
+            batch_hash(t, keys, lens, later, later_to, hashes[(g + 2) % HTAB_BATCH_STAGES], key_lens[(g + 2) % HTAB_BATCH_STAGES]);
+        }
+        if(g + 1 < groups) {
+            size_t next = (g + 1) * HTAB_BATCH_GROUP;
+            size_t next_to = next + HTAB_BATCH_GROUP < n ? next + HTAB_BATCH_GROUP : n;
+            batch_prefetch_items(t, hashes[(g + 1) % HTAB_BATCH_STAGES], next_to - next);
+        }
+
+        for(size_t i = from; i < to; i++) {
+            if(add) {
+                out[i] = htab_lookup_add_hashed(t, group_hashes[i - from], keys[i], group_lens[i - from]);
+                ok = ok && out[i] != NULL;
+            } else {
+                out[i] = htab_find_hashed(t, group_hashes[i - from], keys[i], group_lens[i - from]);
+            }
+        }
+    }
+    return ok;
+}
+
+/**
+ * @brief finds the records of all the keys, the bucket loads of the keys overlap
+ * 
+ * @param t hash table
+ * @param keys keys
+ * @param lens lengths of the keys or NULL for null terminated keys
+ * @param n number of keys
+ * @param out array of n results, NULL where the key was not found
+ */
+void htab_find_batch(const htab_t * t, const char *const *keys, const size_t *lens, size_t n, htab_pair_t **out) {
+    if(htab_readonly(t)) {
+        // the snapshot and the frozen table have no chains to prefetch
+        for(size_t i = 0; i < n; i++) {
+            out[i] = lens != NULL ? htab_find_n(t, keys[i], lens[i]) : htab_find(t, keys[i]);
+        }
+        return;
+    }
+    batch_run((htab_t *)t, keys, lens, n, out, false);
+}
+
+/**
+ * @brief htab_lookup_add for all the keys, the bucket loads of the keys overlap
+ * 
+ * @param t hash table
+ * @param keys keys
+ * @param lens lengths of the keys or NULL for null terminated keys
+ * @param n number of keys
+ * @param out array of n results, NULL where the record could not be created
+ * @return true if all the records were found or created
+ * @return false if something went wrong
+ */
+bool htab_lookup_add_batch(htab_t * t, const char *const *keys, const size_t *lens, size_t n, htab_pair_t **out) {
+    if(htab_readonly(t)) {
+        // the snapshot and the frozen table increment the existing records in place, a new key converts the table
+        bool ok = true;
+        for(size_t i = 0; i < n; i++) {
+            out[i] = lens != NULL ? htab_lookup_add_n(t, keys[i], lens[i]) : htab_lookup_add(t, keys[i]);
+            ok = ok && out[i] != NULL;
+        }
+        return ok;
+    }
+    return batch_run(t, keys, lens, n, out, true);
+}
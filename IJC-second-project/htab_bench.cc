@@ -0,0 +1,358 @@
+// htab_bench.cc
+// Solution IJC-DU2, task b)
+// Author: Adam Běhoun, FIT
+// Date: 17.4.2024
+// login: xbehoua00
+// Compiled: g++ (GCC) 10.5.0
+//
+// Microbenchmark of libhtab with std::unordered_map as the baseline.
+// Every key set is run through lookup_add, find of present and missing keys,
+// erase, for_each and clear, the results are in nanoseconds per operation
+// (per record for for_each and clear). Key sets:
+//  - uniform: every key is equally likely,
+//  - zipf: the k-th most frequent key has frequency 1/k, like words in a text,
+//  - collide: all the keys have the same htab_hash_function value, so they end up
+//    in one chain. They are built from two blocks with equal hashes, std::hash is
+//    not affected, it shows the worst case of htab.
+// htab gets as many buckets as there are keys, it does not grow.
+// The same keys are then looked up in a table made read only by htab_freeze, the misses
+// check that a missing key is never found.
+// The same program is linked with libhtab.a (htab-bench) and libhtab.so (htab-bench-dynamic).
+// Usage: ./htab-bench [maximum number of keys]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+extern "C" {
+#include "htab.h"
+}
+
+namespace {
+
+// bytes currently allocated by the baseline map, its keys included
+std::size_t map_bytes = 0;
+
+template <class T>
+struct counting_allocator {
+    using value_type = T;
+    counting_allocator() = default;
+    template <class U>
+    counting_allocator(const counting_allocator<U> &) {}
+
+    T *allocate(std::size_t n) {
+        map_bytes += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T *p, std::size_t n) {
+        map_bytes -= n * sizeof(T);
+        std::allocator<T>().deallocate(p, n);
+    }
+    template <class U>
+    bool operator==(const counting_allocator<U> &) const { return true; }
+    template <class U>
+    bool operator!=(const counting_allocator<U> &) const { return false; }
+};
+
+using map_key = std::basic_string<char, std::char_traits<char>, counting_allocator<char>>;
+
+struct map_key_hash {
+    std::size_t operator()(const map_key &key) const {
+        return std::hash<std::string_view>()(std::string_view(key.data(), key.size()));
+    }
+};
+
+using map_t = std::unordered_map<map_key, int, map_key_hash, std::equal_to<map_key>,
+                                 counting_allocator<std::pair<const map_key, int>>>;
+
+// keys of one run: stream of operations over keys, keys for the misses
+struct key_set {
+    const char *name;
+    std::vector<std::string> keys;
+    std::vector<std::string> missing;
+    std::vector<std::size_t> stream;    // indices to keys
+};
+
+std::string random_key(std::mt19937_64 &rng, std::size_t len, char first) {
+    std::string key(len, ' ');
+    for (char &c : key)
+        c = static_cast<char>(first + rng() % 26);
+    return key;
+}
+
+// n distinct keys of length len from the letters starting at first
+std::vector<std::string> distinct_keys(std::mt19937_64 &rng, std::size_t n, std::size_t len, char first) {
+    std::unordered_set<std::string> seen;
+    std::vector<std::string> keys;
+    while (keys.size() < n) {
+        std::string key = random_key(rng, len, first);
+        if (seen.insert(key).second)
+            keys.push_back(std::move(key));
+    }
+    return keys;
+}
+
+key_set uniform_set(std::mt19937_64 &rng, std::size_t n, std::size_t len, std::size_t ops) {
+    key_set set{"uniform", distinct_keys(rng, n, len, 'a'), distinct_keys(rng, n, len, 'A'), {}};
+    for (std::size_t i = 0; i < ops; i++)
+        set.stream.push_back(rng() % n);
+    return set;
+}
+
+key_set zipf_set(std::mt19937_64 &rng, std::size_t n, std::size_t len, std::size_t ops) {
+    key_set set{"zipf", distinct_keys(rng, n, len, 'a'), distinct_keys(rng, n, len, 'A'), {}};
+    std::vector<double> cdf(n);
+    double sum = 0;
+    for (std::size_t k = 0; k < n; k++)
+        cdf[k] = sum += 1.0 / (k + 1);
+    std::uniform_real_distribution<double> uniform(0, sum);
+    for (std::size_t i = 0; i < ops; i++) {
+        std::size_t k = std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+        set.stream.push_back(std::min(k, n - 1));
+    }
+    return set;
+}
+
+// 2n keys with the same hash, the first n go to the table, the other n are the misses
+key_set collide_set(std::mt19937_64 &rng, std::size_t n, std::size_t ops) {
+    // birthday search for two different blocks with the same hash, concatenations
+    // of such blocks in any order have the same hash too, as long as they are equally long
+    std::unordered_map<std::size_t, std::string> seen;
+    std::string x, y;
+    while (x.empty()) {
+        std::string block = random_key(rng, 6, 'a');
+        std::size_t hash = htab_hash_function_n(block.data(), block.size());
+        auto [it, inserted] = seen.emplace(hash, block);
+        if (!inserted && it->second != block) {
+            x = it->second;
+            y = block;
+        }
+    }
+
+    std::size_t blocks = 1;
+    while ((std::size_t(1) << blocks) < 2 * n)
+        blocks++;
+    key_set set{"collide", {}, {}, {}};
+    for (std::size_t i = 0; i < 2 * n; i++) {
+        std::string key;
+        for (std::size_t b = 0; b < blocks; b++)
+            key += (i >> b) & 1 ? y : x;
+        (i % 2 == 0 ? set.keys : set.missing).push_back(std::move(key));
+    }
+    for (std::size_t i = 0; i < ops; i++)
+        set.stream.push_back(rng() % n);
+    return set;
+}
+
+double elapsed_ns(std::chrono::steady_clock::time_point start, std::size_t count) {
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / (count > 0 ? count : 1);
+}
+
+struct result {
+    double add, hit, miss, erase, for_each, clear;
+    double bytes_per_entry;
+    long check;     // sum of the values, both tables have to agree
+};
+
+long pair_sum;
+void sum_pair(htab_pair_t *pair) {
+    pair_sum += pair->value;
+}
+
+result run_htab(const key_set &set, htab_stats_t &stats) {
+    result r{};
+    std::size_t n = set.keys.size();
+    htab_t *t = htab_init(n);
+    if (t == nullptr)
+        std::exit(1);
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i : set.stream)
+        htab_lookup_add_n(t, set.keys[i].data(), set.keys[i].size());
+    r.add = elapsed_ns(start, set.stream.size());
+    for (const std::string &key : set.keys)
+        htab_lookup_add_n(t, key.data(), key.size());
+
+    long found = 0;
+    start = std::chrono::steady_clock::now();
+    for (std::size_t i : set.stream)
+        found += htab_find_n(t, set.keys[i].data(), set.keys[i].size())->value;
+    r.hit = elapsed_ns(start, set.stream.size());
+
+    start = std::chrono::steady_clock::now();
+    for (const std::string &key : set.missing)
+        found += htab_find_n(t, key.data(), key.size()) != nullptr;
+    r.miss = elapsed_ns(start, set.missing.size());
+
+    pair_sum = 0;
+    start = std::chrono::steady_clock::now();
+    htab_for_each(t, sum_pair);
+    r.for_each = elapsed_ns(start, n);
+
+    htab_get_stats(t, &stats);
+    r.bytes_per_entry = double(stats.bucket_bytes + stats.item_bytes + stats.key_bytes) / n;
+    r.check = found + pair_sum;
+
+    start = std::chrono::steady_clock::now();
+    for (const std::string &key : set.keys)
+        htab_erase_n(t, key.data(), key.size());
+    r.erase = elapsed_ns(start, n);
+
+    for (const std::string &key : set.keys)
+        htab_lookup_add_n(t, key.data(), key.size());
+    start = std::chrono::steady_clock::now();
+    htab_clear(t);
+    r.clear = elapsed_ns(start, n);
+
+    htab_free(t);
+    return r;
+}
+
+// hits and misses of the same table after htab_freeze
+struct frozen_result {
+    double hit, miss;
+    bool frozen;    // htab_freeze succeeded
+    bool ok;        // every key found with its count, no missing key found
+};
+
+frozen_result run_frozen(const key_set &set) {
+    frozen_result r{};
+    htab_t *t = htab_init(set.keys.size());
+    if (t == nullptr)
+        std::exit(1);
+    for (const std::string &key : set.keys)
+        htab_lookup_add_n(t, key.data(), key.size());
+    for (std::size_t i : set.stream)
+        htab_lookup_add_n(t, set.keys[i].data(), set.keys[i].size())->value++;
+    std::vector<long> counts(set.keys.size());
+    for (std::size_t i = 0; i < set.keys.size(); i++)
+        counts[i] = htab_find_n(t, set.keys[i].data(), set.keys[i].size())->value;
+    if (!htab_freeze(t)) {
+        htab_free(t);
+        return r;
+    }
+
+    r.frozen = r.ok = true;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i : set.stream) {
+        htab_pair_t *pair = htab_find_n(t, set.keys[i].data(), set.keys[i].size());
+        r.ok &= pair != nullptr && pair->value == counts[i];
+    }
+    r.hit = elapsed_ns(start, set.stream.size());
+
+    // the misses land on the slots no key took too
+    start = std::chrono::steady_clock::now();
+    for (const std::string &key : set.missing)
+        r.ok &= htab_find_n(t, key.data(), key.size()) == nullptr;
+    r.miss = elapsed_ns(start, set.missing.size());
+
+    htab_free(t);
+    return r;
+}
+
+result run_map(const key_set &set) {
+    result r{};
+    std::size_t n = set.keys.size();
+    std::vector<map_key> keys(set.keys.begin(), set.keys.end());
+    std::vector<map_key> missing(set.missing.begin(), set.missing.end());
+    std::size_t keys_bytes = map_bytes;
+    map_t m;
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i : set.stream)
+        m[keys[i]]++;
+    r.add = elapsed_ns(start, set.stream.size());
+    for (const map_key &key : keys)
+        m[key]++;
+
+    long found = 0;
+    start = std::chrono::steady_clock::now();
+    for (std::size_t i : set.stream)
+        found += m.find(keys[i])->second;
+    r.hit = elapsed_ns(start, set.stream.size());
+
+    start = std::chrono::steady_clock::now();
+    for (const map_key &key : missing)
+        found += m.find(key) != m.end();
+    r.miss = elapsed_ns(start, missing.size());
+
+    long sum = 0;
+    start = std::chrono::steady_clock::now();
+    for (auto &item : m)
+        sum += item.second;
+    r.for_each = elapsed_ns(start, n);
+
+    r.bytes_per_entry = double(map_bytes - keys_bytes) / n;
+    r.check = found + sum;
+
+    start = std::chrono::steady_clock::now();
+    for (const map_key &key : keys)
+        m.erase(key);
+    r.erase = elapsed_ns(start, n);
+
+    for (const map_key &key : keys)
+        m[key]++;
+    start = std::chrono::steady_clock::now();
+    m.clear();
+    r.clear = elapsed_ns(start, n);
+    return r;
+}
+
+void print_result(const char *table, const result &r) {
+    std::printf("  %-18s add %7.1f  hit %7.1f  miss %7.1f  erase %7.1f  for_each %6.1f  clear %6.1f ns  %6.1f B/entry\n",
+                table, r.add, r.hit, r.miss, r.erase, r.for_each, r.clear, r.bytes_per_entry);
+}
+
+void run(const key_set &set, std::size_t len) {
+    htab_stats_t stats;
+    result h = run_htab(set, stats);
+    frozen_result f = run_frozen(set);
+    result m = run_map(set);
+
+    std::printf("%s: %zu keys of length %zu, %zu operations\n", set.name, set.keys.size(), len, set.stream.size());
+    print_result("htab", h);
+    print_result("std::unordered_map", m);
+    if (f.frozen)
+        std::printf("  %-18s hit %7.1f  miss %7.1f ns\n", "htab frozen", f.hit, f.miss);
+    std::printf("  htab chains: avg %.2f, max %zu, p99 %zu\n", stats.chain_avg, stats.chain_max, stats.chain_p99);
+    if (h.check != m.check)
+        std::fprintf(stderr, "The tables do not agree.\n");
+    if (f.frozen && !f.ok)
+        std::fprintf(stderr, "The frozen table does not agree.\n");
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    std::size_t max_keys = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    std::mt19937_64 rng(42); // the same keys in every run
+
+    for (std::size_t n : {1000, 100000, 1000000}) {
+        if (n > max_keys)
+            break;
+        std::size_t ops = std::max<std::size_t>(4 * n, 1000000);
+        for (std::size_t len : {8, 32}) {
+            run(uniform_set(rng, n, len, ops), len);
+            run(zipf_set(rng, n, len, ops), len);
+        }
+    }
+
+    // every operation walks the whole chain, so the set is kept small
+    for (std::size_t n : {1024, 8192}) {
+        if (n > max_keys)
+            break;
+        key_set set = collide_set(rng, n, 2 * n);
+        run(set, set.keys[0].size());
+    }
+    return 0;
+}
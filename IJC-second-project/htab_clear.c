@@ -15,21 +15,10 @@
  * @param t hash table
  */
 void htab_clear(htab_t * t) {
+    htab_image_free(t); // loaded snapshot is just unmapped
+    htab_frozen_free(t);
 
-    for(int i = 0; i < t->arr_size; i++) {
-        htab_item_t *temp = t->ptr[i];
-        // we need to track next item, so we can fully free the current item and not lose next pointer
-        htab_item_t *next_item = NULL;
-
-        // traverse the linked list and free when we see not-NULL item
-        while(temp != NULL) {
-            next_item = temp->next;
-            free((char*)temp->pair.key); // free the allocated key
-            free(temp);
-            temp = next_item;
-        }
-        t->ptr[i]=NULL;
-    }
+    htab_items_free(t); // frees the keys too, the dense array is passed in order
     t->size = 0; // set number of records to 0
     
 }
\ No newline at end of file
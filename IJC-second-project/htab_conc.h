@@ -0,0 +1,47 @@
+/* htab_conc.h
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#ifndef HTAB_CONC_H__ // prevent multiple includes
+#define HTAB_CONC_H__
+
+#include "htab.h"
+
+// Thread-safe variant of htab with the same interface. Writers lock only the
+// stripe their bucket belongs to, readers do not lock at all and the table
+// grows on its own. Memory of erased records and old bucket arrays is released
+// only after all readers that could see it have finished (epoch based reclamation).
+//
+// Returned pair pointers stay valid until the record is erased. The value may be
+// changed by other threads at the same time, read it with __atomic_load_n.
+// htab_conc_clear and htab_conc_free must not run concurrently with anything else.
+
+struct htab_conc;
+typedef struct htab_conc htab_conc_t;
+
+htab_conc_t *htab_conc_init(const size_t n);
+size_t htab_conc_size(const htab_conc_t * t);
+size_t htab_conc_bucket_count(const htab_conc_t * t);
+
+htab_pair_t * htab_conc_find(const htab_conc_t * t, htab_key_t key);
+htab_pair_t * htab_conc_find_n(const htab_conc_t * t, const char *key, size_t len);
+// value of the found record is incremented atomically, a new record starts with 1
+htab_pair_t * htab_conc_lookup_add(htab_conc_t * t, htab_key_t key);
+htab_pair_t * htab_conc_lookup_add_n(htab_conc_t * t, const char *key, size_t len);
+
+bool htab_conc_erase(htab_conc_t * t, htab_key_t key);
+bool htab_conc_erase_n(htab_conc_t * t, const char *key, size_t len);
+
+// f gets a copy of every pair, records added or erased meanwhile may or may not be visited.
+// f may find, add and erase records of the table (but not clear it), the memory released
+// meanwhile is freed only after the traversal, by a later erase or growth.
+void htab_conc_for_each(const htab_conc_t * t, void (*f)(htab_pair_t *data));
+
+void htab_conc_clear(htab_conc_t * t);
+void htab_conc_free(htab_conc_t * t);
+
+#endif // HTAB_CONC_H__
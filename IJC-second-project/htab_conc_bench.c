@@ -0,0 +1,265 @@
+/* htab_conc_bench.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+// Scaling benchmark of the concurrent table against htab guarded by one global mutex.
+// The churn workload adds and erases keys in all the threads at once, starting from
+// a small table, so the erased records and the bucket arrays replaced by the growth
+// are retired and reclaimed while the other threads use the table.
+// Usage: ./htab-conc-bench [total operations] [distinct keys]
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "htab.h"
+#include "htab_conc.h"
+
+#define DEFAULT_OPERATIONS 4000000
+#define DEFAULT_KEYS 100000
+#define MAX_THREADS 64
+#define KEY_LENGTH 24
+// keys a churn thread keeps in the table before it erases them
+#define CHURN_WINDOW 256
+
+typedef enum bench_op {
+    BENCH_ADD,      // lookup_add of the stream
+    BENCH_FIND,     // find of the stream
+    BENCH_CHURN,    // every thread adds its own keys and erases them CHURN_WINDOW later
+} bench_op_t;
+
+typedef struct bench_arg {
+    htab_t *table;              // table guarded by global_lock or NULL
+    htab_conc_t *conc;          // concurrent table or NULL
+    const char (*keys)[KEY_LENGTH];
+    const size_t *stream;       // indices to keys
+    size_t from;
+    size_t to;
+    size_t key_from;            // own keys of the churn thread
+    size_t key_to;
+    bench_op_t op;
+} bench_arg_t;
+
+static pthread_mutex_t global_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief erases the key from the table of the benchmark
+ * 
+ * @param arg arguments of the thread
+ * @param key key
+ * @return true if the key was erased
+ */
+static bool bench_erase(bench_arg_t *arg, const char *key) {
+    if(arg->conc != NULL) {
+        return htab_conc_erase(arg->conc, key);
+    }
+    pthread_mutex_lock(&global_lock);
+    bool erased = htab_erase(arg->table, key);
+    pthread_mutex_unlock(&global_lock);
+    return erased;
+}
+
+/**
+ * @brief churn of one thread: its keys are added in turns and every key is erased
+ * CHURN_WINDOW additions later, at the end all of them are erased
+ * 
+ * @param arg arguments of the thread
+ * @return size_t number of the successful operations
+ */
+static size_t bench_churn(bench_arg_t *arg) {
+    size_t count = arg->key_to - arg->key_from;
+    // fewer keys in the window than its own keys, so a key is erased before it comes again
+    size_t window = count / 2 < CHURN_WINDOW ? count / 2 : CHURN_WINDOW;
+    size_t done = 0;
+    size_t ops = arg->to - arg->from;
+    size_t added = 0;
+
+    for(size_t i = 0; count > 0 && 2 * i < ops; i++) {
+        const char *key = arg->keys[arg->key_from + i % count];
+        if(arg->conc != NULL) {
+            done += htab_conc_lookup_add(arg->conc, key) != NULL;
+        } else {
+            pthread_mutex_lock(&global_lock);
+            done += htab_lookup_add(arg->table, key) != NULL;
+            pthread_mutex_unlock(&global_lock);
+        }
+        added ++;
+        if(i >= window) {
+            done += bench_erase(arg, arg->keys[arg->key_from + (i - window) % count]);
+        }
+    }
+    for(size_t i = added > window ? added - window : 0; i < added; i++) {
+        done += bench_erase(arg, arg->keys[arg->key_from + i % count]);
+    }
+    return done == 2 * added ? ops : done;
+}
+
+/**
+ * @brief body of one benchmark thread, runs its part of the stream
+ * 
+ * @param data bench_arg_t
+ * @return void* NULL
+ */
+static void *bench_thread(void *data) {
+    bench_arg_t *arg = data;
+    size_t found = 0;
+
+    if(arg->op == BENCH_CHURN) {
+        if(bench_churn(arg) != arg->to - arg->from) {
+            fprintf(stderr, "Unexpected miss in the churn benchmark.\n");
+        }
+        return NULL;
+    }
+
+    for(size_t i = arg->from; i < arg->to; i++) {
+        const char *key = arg->keys[arg->stream[i]];
+        if(arg->conc != NULL) {
+            found += (arg->op == BENCH_ADD ? htab_conc_lookup_add(arg->conc, key) : htab_conc_find(arg->conc, key)) != NULL;
+        } else {
+            pthread_mutex_lock(&global_lock);
+            found += (arg->op == BENCH_ADD ? htab_lookup_add(arg->table, key) : htab_find(arg->table, key)) != NULL;
+            pthread_mutex_unlock(&global_lock);
+        }
+    }
+
+    if(found != arg->to - arg->from) {
+        fprintf(stderr, "Unexpected miss in the benchmark.\n");
+    }
+    return NULL;
+}
+
+/**
+ * @brief runs the stream split over the given number of threads
+ * 
+ * @return double operations per second
+ */
+static double bench_run(int threads, bench_arg_t proto, size_t operations) {
+    pthread_t ids[MAX_THREADS];
+    bench_arg_t args[MAX_THREADS];
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for(int i = 0; i < threads; i++) {
+        args[i] = proto;
+        args[i].from = operations * i / threads;
+        args[i].to = operations * (i + 1) / threads;
+        args[i].key_from = proto.key_to * i / threads;
+        args[i].key_to = proto.key_to * (i + 1) / threads;
+        pthread_create(&ids[i], NULL, bench_thread, &args[i]);
+    }
+    for(int i = 0; i < threads; i++) {
+        pthread_join(ids[i], NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    return operations / seconds;
+}
+
+int main(int argc, char *argv[]) {
+    size_t operations = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_OPERATIONS;
+    size_t key_count = argc > 2 ? strtoul(argv[2], NULL, 10) : DEFAULT_KEYS;
+    if(operations == 0 || key_count == 0) {
+        fprintf(stderr, "Usage: %s [operations] [distinct keys]\n", argv[0]);
+        return 1;
+    }
+
+    char (*keys)[KEY_LENGTH] = malloc(key_count * sizeof(keys[0]));
+    size_t *stream = malloc(operations * sizeof(size_t));
+    if(keys == NULL || stream == NULL) {
+        fprintf(stderr, "Allocation was not successful.\n");
+        free(keys);
+        free(stream);
+        return 1;
+    }
+
+    for(size_t i = 0; i < key_count; i++) {
+        snprintf(keys[i], KEY_LENGTH, "key%zu", i);
+    }
+    // skewed stream like natural text, a few keys are very frequent
+    srand(42);
+    for(size_t i = 0; i < operations; i++) {
+        double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+        stream[i] = (size_t)(key_count * u * u * u) % key_count;
+    }
+
+    printf("%-8s %16s %16s %16s %16s %16s %16s\n", "threads", "mutex add/s", "conc add/s",
+        "mutex find/s", "conc find/s", "mutex churn/s", "conc churn/s");
+    for(int threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        htab_t *table = htab_init(key_count);
+        htab_conc_t *conc = htab_conc_init(1024); // starts small, so the growth is measured too
+        if(table == NULL || conc == NULL) {
+            return 1;
+        }
+
+        bench_arg_t proto = { .keys = (const char (*)[KEY_LENGTH])keys, .stream = stream, .key_to = key_count };
+        double result[6];
+
+        proto.table = table;
+        proto.op = BENCH_ADD;
+        result[0] = bench_run(threads, proto, operations);
+        proto.table = NULL;
+        proto.conc = conc;
+        result[1] = bench_run(threads, proto, operations);
+
+        proto.op = BENCH_FIND;
+        proto.conc = NULL;
+        proto.table = table;
+        result[2] = bench_run(threads, proto, operations);
+        proto.table = NULL;
+        proto.conc = conc;
+        result[3] = bench_run(threads, proto, operations);
+
+        // both tables have to count the same
+        if(htab_size(table) != htab_conc_size(conc)) {
+            fprintf(stderr, "Tables differ in size.\n");
+            return 1;
+        }
+        for(size_t i = 0; i < key_count; i++) {
+            htab_pair_t *a = htab_find(table, keys[i]);
+            htab_pair_t *b = htab_conc_find(conc, keys[i]);
+            if((a == NULL) != (b == NULL) || (a != NULL && a->value != b->value)) {
+                fprintf(stderr, "Tables differ in key %s.\n", keys[i]);
+                return 1;
+            }
+        }
+
+        htab_free(table);
+        htab_conc_free(conc);
+
+        // the churn starts from empty tables, the concurrent one grows while others erase
+        table = htab_init(key_count);
+        conc = htab_conc_init(1); // the smallest table
+        if(table == NULL || conc == NULL) {
+            return 1;
+        }
+        proto.op = BENCH_CHURN;
+        proto.conc = NULL;
+        proto.table = table;
+        result[4] = bench_run(threads, proto, operations);
+        proto.table = NULL;
+        proto.conc = conc;
+        result[5] = bench_run(threads, proto, operations);
+
+        // every key was erased at the end
+        if(htab_size(table) != 0 || htab_conc_size(conc) != 0) {
+            fprintf(stderr, "Tables are not empty after the churn.\n");
+            return 1;
+        }
+
+        printf("%-8d %16.0f %16.0f %16.0f %16.0f %16.0f %16.0f\n", threads,
+            result[0], result[1], result[2], result[3], result[4], result[5]);
+        htab_free(table);
+        htab_conc_free(conc);
+    }
+
+    free(keys);
+    free(stream);
+    return 0;
+}
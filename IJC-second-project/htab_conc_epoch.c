@@ -0,0 +1,202 @@
+/* htab_conc_epoch.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include "htab_conc_struct.h"
+
+// every thread uses one reader counter for all the tables
+static atomic_uint next_shard = 0;
+static _Thread_local unsigned thread_shard = HTAB_CONC_SHARDS;
+// read sections of this thread that are open, in any table
+static _Thread_local unsigned read_depth = 0;
+
+/**
+ * @brief announces a reader in the table. Memory retired after this call is not
+ * freed until the matching htab_conc_read_unlock. Lock-free, it only repeats when
+ * the epoch changes in the meantime.
+ * 
+ * @param t concurrent hash table
+ * @return unsigned token for htab_conc_read_unlock
+ */
+unsigned htab_conc_read_lock(const htab_conc_t * t) {
+    htab_conc_t *table = (htab_conc_t *)t; // the counters are not part of the table contents
+
+    if(thread_shard == HTAB_CONC_SHARDS) {
+        thread_shard = atomic_fetch_add(&next_shard, 1) % HTAB_CONC_SHARDS;
+    }
+    htab_conc_shard_t *shard = &table->shards[thread_shard];
+
+    while(true) {
+        size_t epoch = atomic_load(&table->epoch);
+        atomic_fetch_add(&shard->active[epoch & 1], 1);
+
+        // if the epoch changed before we were counted, the reclaiming thread may have
+        // already checked our counter, so we register again in the new epoch
+        if(atomic_load(&table->epoch) == epoch) {
+            read_depth ++;
+            return thread_shard * 2 + (epoch & 1);
+        }
+        atomic_fetch_sub(&shard->active[epoch & 1], 1);
+    }
+}
+
+/**
+ * @brief leaves the table entered by htab_conc_read_lock
+ * 
+ * @param t concurrent hash table
+ * @param token value returned by htab_conc_read_lock
+ */
+void htab_conc_read_unlock(const htab_conc_t * t, unsigned token) {
+    htab_conc_t *table = (htab_conc_t *)t;
+    read_depth --;
+    atomic_fetch_sub(&table->shards[token / 2].active[token & 1], 1);
+}
+
+/**
+ * @brief frees one retired record, a bucket array with all its nodes
+ * 
+ * @param retired record
+ */
+static void retired_free(htab_conc_retired_t *retired) {
+    if(retired->chains) {
+        htab_conc_buckets_t *buckets = retired->first;
+        for(size_t i = 0; i < buckets->arr_size; i++) {
+            htab_conc_node_t *temp = atomic_load_explicit(&buckets->ptr[i], memory_order_relaxed);
+            while(temp != NULL) {
+                htab_conc_node_t *next_node = atomic_load_explicit(&temp->next, memory_order_relaxed);
+                free(temp);
+                temp = next_node;
+            }
+        }
+    }
+    free(retired->first);
+    free(retired->second);
+}
+
+/**
+ * @brief adds the record to the retired list. Every HTAB_CONC_RETIRE_BATCH records the memory is reclaimed.
+ * 
+ * @param t concurrent hash table
+ * @param first node or bucket array
+ * @param second entry or NULL
+ * @param chains true if first is a bucket array to be freed with its nodes
+ */
+static void retire(htab_conc_t * t, void *first, void *second, bool chains) {
+    htab_conc_retired_t *retired = malloc(sizeof(htab_conc_retired_t));
+    if(retired == NULL) {
+        // a reader cannot wait for the readers, the memory is rather left allocated
+        if(read_depth > 0) {
+            fprintf(stderr, "Allocation was not successful, retired memory is not freed.\n");
+            return;
+        }
+        // we cannot postpone it, so wait for the readers right now
+        htab_conc_retired_t now = { .first = first, .second = second, .chains = chains };
+        htab_conc_reclaim(t);
+        retired_free(&now);
+        return;
+    }
+    retired->first = first;
+    retired->second = second;
+    retired->chains = chains;
+
+    pthread_mutex_lock(&t->retire_lock);
+    retired->next = t->retired;
+    t->retired = retired;
+    bool full = ++t->retired_count >= HTAB_CONC_RETIRE_BATCH;
+    pthread_mutex_unlock(&t->retire_lock);
+
+    if(full) {
+        htab_conc_reclaim(t);
+    }
+}
+
+/**
+ * @brief stores the memory that is no longer reachable from the table, but some
+ * reader may still be looking at it
+ * 
+ * @param t concurrent hash table
+ * @param first node or bucket array
+ * @param second entry or NULL
+ */
+void htab_conc_retire(htab_conc_t * t, void *first, void *second) {
+    retire(t, first, second, false);
+}
+
+/**
+ * @brief retires the bucket array replaced by the growth as one record,
+ * its nodes are freed in one pass after the readers leave, the entries are not touched
+ * 
+ * @param t concurrent hash table
+ * @param buckets bucket array no new reader can reach
+ */
+void htab_conc_retire_buckets(htab_conc_t * t, htab_conc_buckets_t *buckets) {
+    retire(t, buckets, NULL, true);
+}
+
+/**
+ * @brief frees the records of the list
+ * 
+ * @param retired first record
+ */
+static void retired_free_list(htab_conc_retired_t *retired) {
+    while(retired != NULL) {
+        htab_conc_retired_t *next = retired->next;
+        retired_free(retired);
+        free(retired);
+        retired = next;
+    }
+}
+
+/**
+ * @brief frees the retired memory. The epoch is moved forward and we wait until all
+ * readers counted in the previous epoch leave, new readers cannot reach the retired memory.
+ * A thread inside a read section (a callback of htab_conc_for_each) would wait for itself,
+ * so then nothing happens and the memory is freed by a later reclaim.
+ * 
+ * @param t concurrent hash table
+ */
+void htab_conc_reclaim(htab_conc_t * t) {
+    if(read_depth > 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&t->reclaim_lock);
+
+    // take the list out, memory retired from now on waits for the next reclaim
+    pthread_mutex_lock(&t->retire_lock);
+    htab_conc_retired_t *retired = t->retired;
+    t->retired = NULL;
+    t->retired_count = 0;
+    pthread_mutex_unlock(&t->retire_lock);
+
+    size_t epoch = atomic_fetch_add(&t->epoch, 1);
+    for(int i = 0; i < HTAB_CONC_SHARDS; i++) {
+        while(atomic_load(&t->shards[i].active[epoch & 1]) != 0) {
+            sched_yield();
+        }
+    }
+
+    pthread_mutex_unlock(&t->reclaim_lock);
+
+    retired_free_list(retired);
+}
+
+/**
+ * @brief frees all the retired memory without waiting, no thread may be in the table
+ * 
+ * @param t concurrent hash table
+ */
+void htab_conc_reclaim_all(htab_conc_t * t) {
+    htab_conc_retired_t *retired = t->retired;
+    t->retired = NULL;
+    t->retired_count = 0;
+    retired_free_list(retired);
+}
@@ -0,0 +1,59 @@
+/* htab_conc_erase.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include "htab_conc_struct.h"
+
+/**
+ * @brief erase record by key given as pointer and length. The record is unlinked
+ * under the stripe lock and freed after the readers that could see it leave.
+ * 
+ * @param t concurrent hash table
+ * @param key key, does not have to be null terminated
+ * @param len length of the key
+ * @return true if erase was successful
+ * @return false if the key was not found
+ */
+bool htab_conc_erase_n(htab_conc_t * t, const char *key, size_t len) {
+    size_t hash = htab_conc_hash(key, len);
+
+    htab_conc_stripe_t *stripe = &t->stripes[hash % HTAB_CONC_STRIPES];
+    pthread_mutex_lock(&stripe->lock);
+
+    htab_conc_buckets_t *buckets = atomic_load_explicit(&t->buckets, memory_order_acquire);
+    _Atomic(htab_conc_node_t *) *link = &buckets->ptr[hash % buckets->arr_size];
+    htab_conc_node_t *temp = atomic_load_explicit(link, memory_order_relaxed);
+
+    while(temp != NULL) {
+        if(temp->hash == hash && temp->entry->key_len == len && memcmp(temp->entry->key, key, len) == 0) {
+            // readers standing on temp can still continue through its next pointer
+            atomic_store_explicit(link, atomic_load_explicit(&temp->next, memory_order_relaxed), memory_order_release);
+            atomic_fetch_sub_explicit(&stripe->size, 1, memory_order_relaxed);
+            pthread_mutex_unlock(&stripe->lock);
+
+            htab_conc_retire(t, temp, temp->entry);
+            return true;
+        }
+        link = &temp->next;
+        temp = atomic_load_explicit(link, memory_order_relaxed);
+    }
+
+    pthread_mutex_unlock(&stripe->lock);
+    return false;
+}
+
+/**
+ * @brief erase record by given key
+ * 
+ * @param t concurrent hash table
+ * @param key key of record
+ * @return true if erase was successful
+ * @return false if the key was not found
+ */
+bool htab_conc_erase(htab_conc_t * t, htab_key_t key) {
+    return htab_conc_erase_n(t, key, strlen(key));
+}
@@ -0,0 +1,62 @@
+/* htab_conc_find.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include "htab_conc_struct.h"
+
+/**
+ * @brief traverses one chain and finds the node with the key
+ * 
+ * @param temp first node of the chain
+ * @param hash hash of the key
+ * @param key key, does not have to be null terminated
+ * @param len length of the key
+ * @return htab_conc_node_t* found node or NULL
+ */
+htab_conc_node_t *htab_conc_chain_find(htab_conc_node_t *temp, size_t hash, const char *key, size_t len) {
+    while(temp != NULL) {
+        // the hash is stored in the node, so the entry is touched only on a probable match
+        if(temp->hash == hash && temp->entry->key_len == len && memcmp(temp->entry->key, key, len) == 0) {
+            return temp;
+        }
+        temp = atomic_load_explicit(&temp->next, memory_order_acquire);
+    }
+    return NULL;
+}
+
+/**
+ * @brief finds the record by key given as pointer and length, does not take any lock
+ * 
+ * @param t concurrent hash table
+ * @param key key, does not have to be null terminated
+ * @param len length of the key
+ * @return htab_pair_t* pointer to the record or NULL if the key was not found
+ */
+htab_pair_t * htab_conc_find_n(const htab_conc_t * t, const char *key, size_t len) {
+    size_t hash = htab_conc_hash(key, len);
+
+    unsigned token = htab_conc_read_lock(t);
+    htab_conc_buckets_t *buckets = atomic_load_explicit(&((htab_conc_t *)t)->buckets, memory_order_acquire);
+    htab_conc_node_t *head = atomic_load_explicit(&buckets->ptr[hash % buckets->arr_size], memory_order_acquire);
+    htab_conc_node_t *found = htab_conc_chain_find(head, hash, key, len);
+    // the node may be freed once we leave, the entry lives until the record is erased
+    htab_pair_t *pair = found != NULL ? &found->entry->pair : NULL;
+    htab_conc_read_unlock(t, token);
+
+    return pair;
+}
+
+/**
+ * @brief finds the record by its key, does not take any lock
+ * 
+ * @param t concurrent hash table
+ * @param key key of the record
+ * @return htab_pair_t* pointer to the record or NULL if the key was not found
+ */
+htab_pair_t * htab_conc_find(const htab_conc_t * t, htab_key_t key) {
+    return htab_conc_find_n(t, key, strlen(key));
+}
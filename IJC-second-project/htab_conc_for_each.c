@@ -0,0 +1,35 @@
+/* htab_conc_for_each.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include "htab_conc_struct.h"
+
+/**
+ * @brief Applies a given function to all the records in the concurrent hash table.
+ * Runs as a reader, so writers are not blocked.
+ * 
+ * @param t concurrent hash table
+ * @param f pointer to a function with parameter htab_pair_t
+ */
+void htab_conc_for_each(const htab_conc_t * t, void (*f)(htab_pair_t *data)) {
+    unsigned token = htab_conc_read_lock(t);
+    htab_conc_buckets_t *buckets = atomic_load_explicit(&((htab_conc_t *)t)->buckets, memory_order_acquire);
+
+    for(size_t i = 0; i < buckets->arr_size; i++) {
+        htab_conc_node_t *temp = atomic_load_explicit(&buckets->ptr[i], memory_order_acquire);
+        while(temp != NULL) {
+            // create new pair, so the function will not change the original hash table
+            htab_pair_t temp_pair = temp->entry->pair;
+            temp_pair.value = __atomic_load_n(&temp->entry->pair.value, __ATOMIC_RELAXED);
+
+            f(&temp_pair);
+            temp = atomic_load_explicit(&temp->next, memory_order_acquire);
+        }
+    }
+
+    htab_conc_read_unlock(t, token);
+}
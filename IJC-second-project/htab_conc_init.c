@@ -0,0 +1,135 @@
+/* htab_conc_init.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "htab_conc_struct.h"
+
+/**
+ * @brief allocates empty bucket array
+ * 
+ * @param n number of buckets
+ * @return htab_conc_buckets_t* bucket array or NULL if the allocation failed
+ */
+htab_conc_buckets_t *htab_conc_buckets_alloc(size_t n) {
+    htab_conc_buckets_t *buckets = malloc(sizeof(htab_conc_buckets_t) + n * sizeof(buckets->ptr[0]));
+    if(buckets == NULL) {
+        return NULL;
+    }
+    buckets->arr_size = n;
+    for(size_t i = 0; i < n; i++) {
+        atomic_init(&buckets->ptr[i], NULL);
+    }
+    return buckets;
+}
+
+/**
+ * @brief initialize concurrent hash table with at least n buckets
+ * 
+ * @param n number of buckets, rounded up to a multiple of HTAB_CONC_STRIPES
+ * @return htab_conc_t* pointer to the initialized hash table
+ */
+htab_conc_t *htab_conc_init(const size_t n) {
+    htab_conc_t *table = malloc(sizeof(htab_conc_t));
+    if(table == NULL) {
+        fprintf(stderr, "Allocation was not successful.\n");
+        return NULL;
+    }
+
+    size_t arr_size = (n + HTAB_CONC_STRIPES - 1) / HTAB_CONC_STRIPES * HTAB_CONC_STRIPES;
+    htab_conc_buckets_t *buckets = htab_conc_buckets_alloc(arr_size > 0 ? arr_size : HTAB_CONC_STRIPES);
+    if(buckets == NULL) {
+        fprintf(stderr, "Allocation was not successful.\n");
+        free(table);
+        return NULL;
+    }
+    atomic_init(&table->buckets, buckets);
+    atomic_init(&table->epoch, 0);
+
+    for(int i = 0; i < HTAB_CONC_SHARDS; i++) {
+        atomic_init(&table->shards[i].active[0], 0);
+        atomic_init(&table->shards[i].active[1], 0);
+    }
+    for(int i = 0; i < HTAB_CONC_STRIPES; i++) {
+        pthread_mutex_init(&table->stripes[i].lock, NULL);
+        atomic_init(&table->stripes[i].size, 0);
+    }
+
+    pthread_mutex_init(&table->retire_lock, NULL);
+    pthread_mutex_init(&table->reclaim_lock, NULL);
+    table->retired = NULL;
+    table->retired_count = 0;
+
+    return table;
+}
+
+/**
+ * @brief returns the current number of records in the table, the result is
+ * only approximate while other threads are writing
+ * 
+ * @param t concurrent hash table
+ * @return size_t number of the records
+ */
+size_t htab_conc_size(const htab_conc_t * t) {
+    size_t size = 0;
+    for(int i = 0; i < HTAB_CONC_STRIPES; i++) {
+        size += atomic_load_explicit(&t->stripes[i].size, memory_order_relaxed);
+    }
+    return size;
+}
+
+/**
+ * @brief returns the current number of buckets
+ * 
+ * @param t concurrent hash table
+ * @return size_t number of buckets
+ */
+size_t htab_conc_bucket_count(const htab_conc_t * t) {
+    return atomic_load(&((htab_conc_t *)t)->buckets)->arr_size;
+}
+
+/**
+ * @brief clears all the records, must not run concurrently with other operations
+ * 
+ * @param t concurrent hash table
+ */
+void htab_conc_clear(htab_conc_t * t) {
+    htab_conc_reclaim_all(t);
+
+    htab_conc_buckets_t *buckets = atomic_load(&t->buckets);
+    for(size_t i = 0; i < buckets->arr_size; i++) {
+        htab_conc_node_t *temp = atomic_load(&buckets->ptr[i]);
+        while(temp != NULL) {
+            htab_conc_node_t *next_node = atomic_load(&temp->next);
+            free(temp->entry);
+            free(temp);
+            temp = next_node;
+        }
+        atomic_store(&buckets->ptr[i], NULL);
+    }
+    for(int i = 0; i < HTAB_CONC_STRIPES; i++) {
+        atomic_store_explicit(&t->stripes[i].size, 0, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief frees the entire concurrent hash table, must not run concurrently with other operations
+ * 
+ * @param t concurrent hash table
+ */
+void htab_conc_free(htab_conc_t * t) {
+    htab_conc_clear(t);
+    free(atomic_load(&t->buckets));
+
+    for(int i = 0; i < HTAB_CONC_STRIPES; i++) {
+        pthread_mutex_destroy(&t->stripes[i].lock);
+    }
+    pthread_mutex_destroy(&t->retire_lock);
+    pthread_mutex_destroy(&t->reclaim_lock);
+    free(t);
+}
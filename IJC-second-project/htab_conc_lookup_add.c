@@ -0,0 +1,160 @@
+/* htab_conc_lookup_add.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "htab_conc_struct.h"
+
+/**
+ * @brief doubles the number of buckets. All the stripes are locked, so no writer
+ * runs, but readers keep traversing the old array. That is why the nodes are copied
+ * instead of relinked, the old array with its nodes is freed after the readers leave.
+ * 
+ * @param t concurrent hash table
+ * @param old bucket array the caller saw as too small
+ */
+void htab_conc_grow(htab_conc_t * t, htab_conc_buckets_t *old) {
+    for(int i = 0; i < HTAB_CONC_STRIPES; i++) {
+        pthread_mutex_lock(&t->stripes[i].lock);
+    }
+
+    // another thread could grow the table while we waited for the locks
+    htab_conc_buckets_t *buckets = atomic_load(&t->buckets);
+    htab_conc_buckets_t *new_buckets = NULL;
+    if(buckets == old) {
+        new_buckets = htab_conc_buckets_alloc(buckets->arr_size * 2);
+    }
+
+    bool copied = new_buckets != NULL;
+    for(size_t i = 0; copied && i < buckets->arr_size; i++) {
+        htab_conc_node_t *temp = atomic_load_explicit(&buckets->ptr[i], memory_order_relaxed);
+        while(temp != NULL) {
+            htab_conc_node_t *node = malloc(sizeof(htab_conc_node_t));
+            if(node == NULL) {
+                copied = false;
+                break;
+            }
+            size_t position = temp->hash % new_buckets->arr_size;
+            node->hash = temp->hash;
+            node->entry = temp->entry;
+            atomic_init(&node->next, atomic_load_explicit(&new_buckets->ptr[position], memory_order_relaxed));
+            atomic_store_explicit(&new_buckets->ptr[position], node, memory_order_relaxed);
+            temp = atomic_load_explicit(&temp->next, memory_order_relaxed);
+        }
+    }
+
+    if(copied) {
+        atomic_store_explicit(&t->buckets, new_buckets, memory_order_release);
+    } else if(new_buckets != NULL) {
+        // not enough memory for the copy, the table stays as it is, only the chains are longer
+        old = new_buckets;
+    } else {
+        old = NULL;
+    }
+
+    for(int i = HTAB_CONC_STRIPES - 1; i >= 0; i--) {
+        pthread_mutex_unlock(&t->stripes[i].lock);
+    }
+
+    if(old == NULL) {
+        return;
+    }
+
+    // the unused array (old or the failed copy) is not reachable by new readers,
+    // it goes with its nodes as one record and is freed after one wait for the readers
+    htab_conc_retire_buckets(t, old);
+    htab_conc_reclaim(t);
+}
+
+/**
+ * @brief finds the record by key given as pointer and length and atomically increments
+ * its value. Hits do not take any lock, only the insertion locks the stripe of the bucket.
+ * 
+ * @param t concurrent hash table
+ * @param key key, does not have to be null terminated
+ * @param len length of the key
+ * @return htab_pair_t* pointer to the record
+ * @return NULL if something went wrong
+ */
+htab_pair_t * htab_conc_lookup_add_n(htab_conc_t * t, const char *key, size_t len) {
+    size_t hash = htab_conc_hash(key, len);
+
+    // the fast path for keys already in the table
+    unsigned token = htab_conc_read_lock(t);
+    htab_conc_buckets_t *buckets = atomic_load_explicit(&t->buckets, memory_order_acquire);
+    htab_conc_node_t *head = atomic_load_explicit(&buckets->ptr[hash % buckets->arr_size], memory_order_acquire);
+    htab_conc_node_t *found = htab_conc_chain_find(head, hash, key, len);
+    if(found != NULL) {
+        // the node may be freed once we leave, the entry lives until the record is erased
+        htab_pair_t *pair = &found->entry->pair;
+        __atomic_fetch_add(&pair->value, 1, __ATOMIC_RELAXED);
+        htab_conc_read_unlock(t, token);
+        return pair;
+    }
+    htab_conc_read_unlock(t, token);
+
+    htab_conc_stripe_t *stripe = &t->stripes[hash % HTAB_CONC_STRIPES];
+    pthread_mutex_lock(&stripe->lock);
+
+    // the array cannot change while we hold the lock, but it could before we got it
+    buckets = atomic_load_explicit(&t->buckets, memory_order_acquire);
+    _Atomic(htab_conc_node_t *) *bucket = &buckets->ptr[hash % buckets->arr_size];
+    head = atomic_load_explicit(bucket, memory_order_relaxed);
+
+    // someone may have inserted the key in the meantime
+    found = htab_conc_chain_find(head, hash, key, len);
+    if(found != NULL) {
+        __atomic_fetch_add(&found->entry->pair.value, 1, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&stripe->lock);
+        return &found->entry->pair;
+    }
+
+    htab_conc_entry_t *entry = malloc(sizeof(htab_conc_entry_t) + len + 1);
+    htab_conc_node_t *node = malloc(sizeof(htab_conc_node_t));
+    if(entry == NULL || node == NULL) {
+        pthread_mutex_unlock(&stripe->lock);
+        fprintf(stderr, "Allocation of new item was not succesfull.\n");
+        free(entry);
+        free(node);
+        return NULL;
+    }
+    memcpy(entry->key, key, len);
+    entry->key[len] = '\0';
+    entry->key_len = len;
+    entry->pair.key = entry->key;
+    entry->pair.value = 1;
+
+    node->hash = hash;
+    node->entry = entry;
+    atomic_init(&node->next, head);
+
+    // the node is complete before it becomes visible to the readers
+    atomic_store_explicit(bucket, node, memory_order_release);
+
+    size_t size = atomic_fetch_add_explicit(&stripe->size, 1, memory_order_relaxed) + 1;
+    bool grow = size > buckets->arr_size / HTAB_CONC_STRIPES * HTAB_CONC_MAX_LOAD;
+    pthread_mutex_unlock(&stripe->lock);
+
+    if(grow) {
+        htab_conc_grow(t, buckets);
+    }
+    return &entry->pair;
+}
+
+/**
+ * @brief finds the record by key and atomically increments its value,
+ * creates a new record with value 1 if the key is not in the table
+ * 
+ * @param t concurrent hash table
+ * @param key key of the record
+ * @return htab_pair_t* pointer to the record
+ * @return NULL if something went wrong
+ */
+htab_pair_t * htab_conc_lookup_add(htab_conc_t * t, htab_key_t key) {
+    return htab_conc_lookup_add_n(t, key, strlen(key));
+}
@@ -0,0 +1,109 @@
+/* htab_conc_struct.h
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#ifndef HTAB_CONC_STRUCT_H // prevent multiple includes
+#define HTAB_CONC_STRUCT_H
+
+#include <stdatomic.h>
+#include <pthread.h>
+#include "htab_conc.h"
+
+// number of writer locks, the bucket count is always a multiple of it,
+// so a bucket stays in the same stripe after the table grows
+#define HTAB_CONC_STRIPES 64
+
+// number of reader counters, threads are spread over them to avoid sharing one cache line
+#define HTAB_CONC_SHARDS 64
+
+// the table grows twice when a stripe holds more than this many records per bucket
+#define HTAB_CONC_MAX_LOAD 2
+
+// erased records are released in batches of this size
+#define HTAB_CONC_RETIRE_BATCH 1024
+
+#define HTAB_CONC_CACHE_LINE 64
+
+// the record itself, it never moves, so the pair pointer is stable
+typedef struct htab_conc_entry {
+    htab_pair_t pair;
+    size_t key_len;
+    char key[];
+} htab_conc_entry_t;
+
+// chain node pointing to the record, nodes are rebuilt when the table grows
+typedef struct htab_conc_node {
+    _Atomic(struct htab_conc_node *) next;
+    size_t hash;
+    htab_conc_entry_t *entry;
+} htab_conc_node_t;
+
+typedef struct htab_conc_buckets {
+    size_t arr_size;
+    _Atomic(htab_conc_node_t *) ptr[];
+} htab_conc_buckets_t;
+
+// memory waiting until no reader can see it
+typedef struct htab_conc_retired {
+    struct htab_conc_retired *next;
+    void *first;    // node or bucket array
+    void *second;   // entry of the erased node or NULL
+    bool chains;    // first is a bucket array replaced by the growth, its nodes go with it
+} htab_conc_retired_t;
+
+typedef struct htab_conc_stripe {
+    pthread_mutex_t lock;
+    atomic_size_t size;    // records in buckets of this stripe, changed under lock, htab_conc_size reads it without
+    char padding[HTAB_CONC_CACHE_LINE];
+} htab_conc_stripe_t;
+
+typedef struct htab_conc_shard {
+    atomic_size_t active[2];    // readers inside the table for even and odd epochs
+    char padding[HTAB_CONC_CACHE_LINE - 2 * sizeof(atomic_size_t)];
+} htab_conc_shard_t;
+
+struct htab_conc {
+    _Atomic(htab_conc_buckets_t *) buckets;
+    atomic_size_t epoch;
+    htab_conc_shard_t shards[HTAB_CONC_SHARDS];
+    htab_conc_stripe_t stripes[HTAB_CONC_STRIPES];
+
+    pthread_mutex_t retire_lock;    // guards retired and retired_count
+    htab_conc_retired_t *retired;
+    size_t retired_count;
+    pthread_mutex_t reclaim_lock;   // only one thread waits for the readers at a time
+};
+
+// htab_hash_function has weak low bits and the bucket count here is a multiple
+// of HTAB_CONC_STRIPES (not a prime), so the bits are mixed before use
+static inline size_t htab_conc_hash(const char *key, size_t len) {
+    size_t h = htab_hash_function_n(key, len);
+    h ^= h >> 16;
+    h *= 0x45d9f3b;
+    h ^= h >> 16;
+    return h;
+}
+
+// reader side of the reclamation, returns the token for htab_conc_read_unlock
+unsigned htab_conc_read_lock(const htab_conc_t * t);
+void htab_conc_read_unlock(const htab_conc_t * t, unsigned token);
+
+// postpones freeing of the memory, first and second are freed after the readers leave
+void htab_conc_retire(htab_conc_t * t, void *first, void *second);
+// the same for the whole bucket array with its nodes, the entries stay
+void htab_conc_retire_buckets(htab_conc_t * t, htab_conc_buckets_t *buckets);
+// frees all the retired memory, waits for the readers that can still see it,
+// called inside a read section it leaves the memory for a later call
+void htab_conc_reclaim(htab_conc_t * t);
+// frees all the retired memory at once, when nothing else runs in the table
+void htab_conc_reclaim_all(htab_conc_t * t);
+
+htab_conc_buckets_t *htab_conc_buckets_alloc(size_t n);
+htab_conc_node_t *htab_conc_chain_find(htab_conc_node_t *temp, size_t hash, const char *key, size_t len);
+void htab_conc_grow(htab_conc_t * t, htab_conc_buckets_t *old);
+
+#endif // HTAB_CONC_STRUCT_H
@@ -10,36 +10,55 @@
 #include "htab_struct.h"
 
 /**
- * @brief erase record in hash table by given key
+ * @brief erase record with already hashed key of given length
  * 
  * @param t hash table
- * @param key key of record
+ * @param hash hash of the key
+ * @param key key of record, does not have to be null terminated
+ * @param len length of the key
  * @return true if erase was successful
- * @return false if something went wrong
+ * @return false if the key was not found
  */
-bool htab_erase(htab_t * t, htab_key_t key) {
-    size_t position = htab_hash_function(key) % t->arr_size;
+bool htab_erase_hashed(htab_t * t, size_t hash, const char *key, size_t len) {
+    // the snapshot and the frozen table are converted before the first change,
+    // there is no need to do it if the key is not there
+    if(htab_readonly(t) && (htab_find_hashed(t, hash, key, len) == NULL || !htab_thaw(t))) {
+        return false;
+    }
+
+    if(t->pool != NULL && (key = htab_pool_find_hashed(t->pool, hash, key, len)) == NULL) {
+        return false;
+    }
+
+    size_t position = hash % t->arr_size;
     
-    htab_item_t *temp = t->ptr[position];
-    htab_item_t *prev = NULL;
-    while(temp != NULL) {
-        if(strcmp(temp->pair.key, key) == 0) {
-            if(prev == NULL) { // if the key is on the first position
-                t->ptr[position] = temp->next; // update the first item of the list
-            } else {
-                prev->next = temp->next; // else, reconnect the linked list after free
-            }
-            temp->next = NULL;
-            
-            free((char*)temp->pair.key); // free allocated char for new key
-            free(temp);
+    uint32_t *link = &t->ptr[position]; // the bucket or next of the previous item
+    while(*link != 0) {
+        htab_item_t *temp = htab_slot(t, *link - 1);
+        if(htab_item_match(t, temp, key, len)) {
+            uint32_t slot = *link - 1;
+            *link = temp->next; // reconnect the linked list before the item is freed
+
+            htab_item_free(t, slot); // frees the key too, unless it is pooled
 
             t->size --; // decrement the number of records in hash table
+            HTAB_COUNT(t, erases, 1);
             return true;
         } else {
-            prev = temp; // update pointers
-            temp = temp->next;
+            link = &temp->next; // update pointers
         }
     }
     return false;
+}
+
+/**
+ * @brief erase record in hash table by given key
+ * 
+ * @param t hash table
+ * @param key key of record
+ * @return true if erase was successful
+ * @return false if something went wrong
+ */
+bool htab_erase(htab_t * t, htab_key_t key) {
+    return htab_erase_hashed(t, htab_hash_function(key), key, strlen(key));
 }
\ No newline at end of file
@@ -0,0 +1,81 @@
+/* htab_erase_if.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include "htab_struct.h"
+
+/**
+ * @brief erases all the records the predicate holds for, in one pass over the buckets.
+ * The erased items are unlinked right in their chains and their slots are put to the list
+ * of free slots, so no key is hashed again and the remaining records stay where they are.
+ * When no record remains, all the chunks are freed at once.
+ * 
+ * @param t hash table
+ * @param pred predicate, it may change the value of the record
+ * @param ctx passed to the predicate
+ * @return size_t number of the erased records
+ */
+size_t htab_erase_if(htab_t * t, bool (*pred)(htab_pair_t *data, void *ctx), void *ctx) {
+    // the snapshot and the frozen table are converted first
+    if(htab_readonly(t) && !htab_thaw(t)) {
+        return 0;
+    }
+
+    size_t erased = 0;
+    for(int i = 0; i < t->arr_size; i++) {
+        uint32_t *link = &t->ptr[i]; // the bucket or next of the previous item
+        while(*link != 0) {
+            uint32_t slot = *link - 1;
+            htab_item_t *temp = htab_slot(t, slot);
+            if(pred(&temp->pair, ctx)) {
+                *link = temp->next;
+                htab_item_free(t, slot); // frees the key too, unless it is pooled
+                erased ++;
+            } else {
+                link = &temp->next;
+            }
+        }
+    }
+
+    t->size -= erased;
+    if(t->size == 0) {
+        htab_items_free(t);
+    }
+    HTAB_COUNT(t, erases, erased);
+    return erased;
+}
+
+// predicate of htab_retain with its context
+typedef struct retain_ctx {
+    bool (*pred)(htab_pair_t *data, void *ctx);
+    void *ctx;
+} retain_ctx_t;
+
+/**
+ * @brief negation of the predicate of htab_retain
+ * 
+ * @param data record
+ * @param ctx retain_ctx_t with the original predicate
+ * @return true if the record should be erased
+ */
+static bool retain_not(htab_pair_t *data, void *ctx) {
+    retain_ctx_t *retain = ctx;
+    return !retain->pred(data, retain->ctx);
+}
+
+/**
+ * @brief keeps only the records the predicate holds for, the rest is erased as by htab_erase_if
+ * 
+ * @param t hash table
+ * @param pred predicate, it may change the value of the record
+ * @param ctx passed to the predicate
+ * @return size_t number of the erased records
+ */
+size_t htab_retain(htab_t * t, bool (*pred)(htab_pair_t *data, void *ctx), void *ctx) {
+    retain_ctx_t retain = {pred, ctx};
+    return htab_erase_if(t, retain_not, &retain);
+}
@@ -0,0 +1,22 @@
+/* htab_erase_n.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include "htab_struct.h"
+
+/**
+ * @brief erase record in hash table by key given as pointer and length
+ * 
+ * @param t hash table
+ * @param key key of the record, does not have to be null terminated
+ * @param len length of the key
+ * @return true if erase was successful
+ * @return false if the key was not found
+ */
+bool htab_erase_n(htab_t * t, const char *key, size_t len) {
+    return htab_erase_hashed(t, htab_hash_function_n(key, len), key, len);
+}
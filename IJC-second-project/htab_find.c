@@ -11,29 +11,62 @@
 #include "htab_item.h"
 
 /**
- * @brief finds the record in hash table by its key and returns pointer to the record
+ * @brief finds the record with already hashed key of given length
  * 
  * @param t hash table
- * @param key key of the record
+ * @param hash hash of the key
+ * @param key key of the record, does not have to be null terminated
+ * @param len length of the key
  * @return htab_pair_t* pointer to the records that contains the key
  * @return NULL if the key was not found
  */
-htab_pair_t * htab_find(const htab_t * t, htab_key_t key) {
+htab_pair_t * htab_find_hashed(const htab_t * t, size_t hash, const char *key, size_t len) {
+
+    // loaded snapshot is searched right in the mapped file, frozen table has its own hash
+    if(htab_readonly(t)) {
+        return t->image != NULL ? htab_image_find(t, hash, key, len) : htab_frozen_find(t, key, len);
+    }
 
-    // calculate the position using hash function and modulo
-    size_t position = htab_hash_function(key) % t->arr_size;
+    // a key missing in the pool is not in any of its tables
+    if(t->pool != NULL && (key = htab_pool_find_hashed(t->pool, hash, key, len)) == NULL) {
+        HTAB_COUNT(t, lookups, 1);
+        return NULL;
+    }
+
+    // calculate the position using modulo
+    size_t position = hash % t->arr_size;
 
-    htab_item_t *temp = t->ptr[position];
+    htab_item_t *temp = htab_chain(t, t->ptr[position]);
+    size_t compares = 0; // counted locally and stored once at the end
     // traverse the linked list in the calculated position
     while(temp != NULL) {
-        if(strcmp(temp->pair.key, key) == 0) {
+        compares ++;
+        if(htab_item_match(t, temp, key, len)) {
+            HTAB_COUNT(t, lookups, 1);
+            HTAB_COUNT(t, hits, 1);
+            HTAB_COUNT(t, key_compares, compares);
             return &temp->pair; // return the pointer 
         } else {
-            temp = temp->next;
+            temp = htab_chain(t, temp->next);
         }
     }
 
+    HTAB_COUNT(t, lookups, 1);
+    HTAB_COUNT(t, key_compares, compares);
+
     // if the key was not found, return NULL
     return NULL;
 }
 
+/**
+ * @brief finds the record in hash table by its key and returns pointer to the record
+ * 
+ * @param t hash table
+ * @param key key of the record
+ * @return htab_pair_t* pointer to the records that contains the key
+ * @return NULL if the key was not found
+ */
+htab_pair_t * htab_find(const htab_t * t, htab_key_t key) {
+    return htab_find_hashed(t, htab_hash_function(key), key, strlen(key));
+}
+
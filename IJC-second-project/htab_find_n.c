@@ -0,0 +1,22 @@
+/* htab_find_n.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include "htab_struct.h"
+
+/**
+ * @brief finds the record in hash table by key given as pointer and length
+ * 
+ * @param t hash table
+ * @param key key of the record, does not have to be null terminated
+ * @param len length of the key
+ * @return htab_pair_t* pointer to the records that contains the key
+ * @return NULL if the key was not found
+ */
+htab_pair_t * htab_find_n(const htab_t * t, const char *key, size_t len) {
+    return htab_find_hashed(t, htab_hash_function_n(key, len), key, len);
+}
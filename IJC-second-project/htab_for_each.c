@@ -15,15 +15,33 @@
  * @param f pointer to a function with parameter htab_pair_t
  */
 void htab_for_each(const htab_t *t, void (*f)(htab_pair_t *data)) {
-    // traverse the entire hash table
-    for(int i = 0; i < t->arr_size; i++) {
-        htab_item_t *temp = t->ptr[i];
-        while(temp != NULL) {
-            // create new pair, so the function will not change the original hash table
-            htab_pair_t temp_pair = temp->pair;
-
-            f(&temp_pair); // apply the function on the pair
-            temp = temp->next;
+    // the function gets a copy anyway, so the loaded snapshot is traversed in place
+    if(t->image != NULL) {
+        const htab_image_t *image = t->image;
+        for(int i = 0; i < t->size; i++) {
+            htab_pair_t temp_pair = {
+                .key = image->keys + image->entries[i].key_offset,
+                .value = htab_image_value(image, i),
+            };
+            f(&temp_pair);
+        }
+        return;
+    }
+    if(t->frozen != NULL) {
+        for(int i = 0; i < t->size; i++) {
+            htab_pair_t temp_pair = t->frozen->entries[i].pair;
+            f(&temp_pair);
         }
+        return;
+    }
+
+    // traverse the dense array of the records, in the order they were added
+    size_t slot = 0;
+    htab_item_t *temp;
+    while((temp = htab_item_next(t, &slot, t->used)) != NULL) {
+        // create new pair, so the function will not change the original hash table
+        htab_pair_t temp_pair = temp->pair;
+
+        f(&temp_pair); // apply the function on the pair
     }
 }
\ No newline at end of file
@@ -16,5 +16,6 @@
  */
 void htab_free(htab_t * t) {
     htab_clear(t);
+    free(t->counters);
     free(t);
 }
\ No newline at end of file
@@ -0,0 +1,340 @@
+/* htab_freeze.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "htab_struct.h"
+
+// average number of keys in one bucket of the pilots
+#define FROZEN_BUCKET_KEYS 4
+// slots are about 2 % more than keys, the last buckets find a free slot sooner
+#define FROZEN_SLOT_SPARE 50
+// how many seeds we try before giving up (duplicate 64-bit hashes are the only realistic cause)
+#define FROZEN_SEEDS 8
+#define FROZEN_MAX_PILOT UINT16_MAX
+
+/**
+ * @brief mixes the bits of the number, the finalizer of splitmix64
+ */
+static inline uint64_t frozen_mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+ * @brief 64-bit hash of the key. htab_hash_function has only 32 bits, so with
+ * millions of keys some of them would collide and no perfect hash would exist.
+ * 
+ * @param key key, does not have to be null terminated
+ * @param len length of the key
+ * @param seed seed of the hash
+ * @return uint64_t hash
+ */
+static inline uint64_t frozen_hash(const char *key, size_t len, uint64_t seed) {
+    uint64_t h = 0xcbf29ce484222325ULL ^ seed; // FNV-1a
+    const unsigned char *p = (const unsigned char *)key;
+    for(size_t i = 0; i < len; i++) {
+        h = (h ^ p[i]) * 0x100000001b3ULL;
+    }
+    return frozen_mix(h);
+}
+
+static inline size_t frozen_bucket(const htab_frozen_t *frozen, uint64_t hash) {
+    return ((hash >> 32) * frozen->bucket_count) >> 32;
+}
+
+// the whole hash is mixed with the pilot before the reduction, keys of one bucket
+// that share the low bits would otherwise collide for every pilot when the slot count
+// is a power of two. The reduction multiplies like frozen_bucket, slot_count fits in 32 bits.
+static inline size_t frozen_slot(const htab_frozen_t *frozen, uint64_t hash, uint16_t pilot) {
+    return ((frozen_mix(hash ^ frozen_mix(pilot + 1)) >> 32) * frozen->slot_count) >> 32;
+}
+
+/**
+ * @brief finds the pilots for all the buckets, the biggest buckets go first
+ * while most of the slots are still free
+ * 
+ * @param frozen table with seed and sizes set
+ * @param hashes hashes of the keys
+ * @param n number of keys
+ * @return true if every bucket got its pilot
+ * @return false if some bucket has no pilot, another seed has to be tried
+ */
+static bool frozen_pilots(htab_frozen_t *frozen, const uint64_t *hashes, size_t n) {
+    size_t buckets = frozen->bucket_count;
+    size_t *starts = calloc(buckets + 2, sizeof(size_t));
+    size_t *keys = malloc(n * sizeof(size_t));
+    size_t *order = malloc(buckets * sizeof(size_t));
+    uint64_t *taken = calloc((frozen->slot_count + 63) / 64, sizeof(uint64_t));
+    size_t *slots = NULL;
+    bool ok = starts != NULL && keys != NULL && order != NULL && taken != NULL;
+
+    // counting sort of the keys by their bucket
+    size_t max_size = 0;
+    for(size_t i = 0; ok && i < n; i++) {
+        starts[frozen_bucket(frozen, hashes[i]) + 2] ++;
+    }
+    for(size_t b = 0; ok && b < buckets; b++) {
+        max_size = starts[b + 2] > max_size ? starts[b + 2] : max_size;
+        starts[b + 2] += starts[b + 1];
+    }
+    for(size_t i = 0; ok && i < n; i++) {
+        keys[starts[frozen_bucket(frozen, hashes[i]) + 1] ++] = i;
+    }
+    // now the bucket b has keys[starts[b]] .. keys[starts[b+1] - 1]
+
+    // counting sort of the buckets by their size, descending
+    size_t *by_size = ok ? calloc(max_size + 2, sizeof(size_t)) : NULL;
+    slots = ok ? malloc((max_size + 1) * sizeof(size_t)) : NULL;
+    ok = ok && by_size != NULL && slots != NULL;
+    for(size_t b = 0; ok && b < buckets; b++) {
+        by_size[max_size - (starts[b + 1] - starts[b]) + 1] ++;
+    }
+    for(size_t s = 0; ok && s <= max_size; s++) {
+        by_size[s + 1] += by_size[s];
+    }
+    for(size_t b = 0; ok && b < buckets; b++) {
+        order[by_size[max_size - (starts[b + 1] - starts[b])] ++] = b;
+    }
+    free(by_size);
+
+    for(size_t o = 0; ok && o < buckets; o++) {
+        size_t b = order[o];
+        size_t size = starts[b + 1] - starts[b];
+        if(size == 0) {
+            frozen->pilots[b] = 0;
+            continue;
+        }
+
+        bool found = false;
+        for(uint32_t pilot = 0; !found && pilot <= FROZEN_MAX_PILOT; pilot++) {
+            size_t placed = 0;
+            for(; placed < size; placed++) {
+                size_t slot = frozen_slot(frozen, hashes[keys[starts[b] + placed]], pilot);
+                if(taken[slot / 64] & (1ULL << (slot % 64))) {
+                    break;
+                }
+                taken[slot / 64] |= 1ULL << (slot % 64); // also catches two keys of the bucket in one slot
+                slots[placed] = slot;
+            }
+
+            if(placed == size) {
+                frozen->pilots[b] = pilot;
+                found = true;
+            } else {
+                for(size_t i = 0; i < placed; i++) { // give the slots back
+                    taken[slots[i] / 64] &= ~(1ULL << (slots[i] % 64));
+                }
+            }
+        }
+        ok = found;
+    }
+
+    // taken slots behind n point to the free slots in front of n,
+    // the others may be left from another seed, they are below n anyway
+    size_t free_slot = 0;
+    for(size_t slot = n; ok && slot < frozen->slot_count; slot++) {
+        if(taken[slot / 64] & (1ULL << (slot % 64))) {
+            while(taken[free_slot / 64] & (1ULL << (free_slot % 64))) {
+                free_slot ++;
+            }
+            frozen->remap[slot - n] = free_slot++;
+        }
+    }
+
+    free(starts);
+    free(keys);
+    free(order);
+    free(taken);
+    free(slots);
+    return ok;
+}
+
+/**
+ * @brief returns the index of the record the key could be at
+ */
+static inline size_t frozen_index(const htab_frozen_t *frozen, size_t n, uint64_t hash) {
+    size_t slot = frozen_slot(frozen, hash, frozen->pilots[frozen_bucket(frozen, hash)]);
+    return slot < n ? slot : frozen->remap[slot - n];
+}
+
+/**
+ * @brief freezes the table: builds a minimal perfect hash over the current keys and
+ * moves the records to one compact array, the chains are freed. Then htab_find takes
+ * one probe and one key comparison. Adding a new key or erasing one converts the table back.
+ * 
+ * @param t hash table
+ * @return true if the table is frozen
+ * @return false if something went wrong, the table stays as it was
+ */
+bool htab_freeze(htab_t * t) {
+    if(t->frozen != NULL) {
+        return true;
+    }
+    // the frozen records own their keys, the pooled ones would lose the pointer equality
+    if(t->pool != NULL) {
+        fprintf(stderr, "A table with pooled keys can not be frozen.\n");
+        return false;
+    }
+    if(t->image != NULL && !htab_thaw(t)) {
+        return false;
+    }
+
+    size_t n = t->size;
+    if(n > UINT32_MAX - UINT32_MAX / FROZEN_SLOT_SPARE - 1) { // the slots have to fit in 32 bits
+        fprintf(stderr, "Too many records to freeze.\n");
+        return false;
+    }
+
+    htab_frozen_t *frozen = calloc(1, sizeof(htab_frozen_t));
+    uint64_t *hashes = malloc((n > 0 ? n : 1) * sizeof(uint64_t));
+    htab_item_t **items = malloc((n > 0 ? n : 1) * sizeof(htab_item_t*));
+    bool ok = frozen != NULL && hashes != NULL && items != NULL;
+
+    size_t key_bytes = 0;
+    if(ok) {
+        frozen->bucket_count = n / FROZEN_BUCKET_KEYS + 1;
+        frozen->slot_count = n + n / FROZEN_SLOT_SPARE + 1;
+        frozen->pilots = malloc(frozen->bucket_count * sizeof(uint16_t));
+        // the slots no key took point to record 0, a missing key is rejected by the key comparison
+        frozen->remap = calloc(frozen->slot_count - n, sizeof(uint32_t));
+        frozen->entries = malloc((n > 0 ? n : 1) * sizeof(htab_frozen_entry_t));
+        ok = frozen->pilots != NULL && frozen->remap != NULL && frozen->entries != NULL;
+
+        size_t i = 0;
+        size_t slot = 0;
+        htab_item_t *temp;
+        while(ok && (temp = htab_item_next(t, &slot, t->used)) != NULL) {
+            items[i++] = temp;
+            key_bytes += temp->key_len + 1;
+        }
+        frozen->keys = ok ? malloc(key_bytes > 0 ? key_bytes : 1) : NULL;
+        ok = ok && frozen->keys != NULL;
+    }
+
+    bool built = false;
+    for(uint64_t seed = 0; ok && !built && seed < FROZEN_SEEDS; seed++) {
+        frozen->seed = frozen_mix(seed);
+        for(size_t i = 0; i < n; i++) {
+            hashes[i] = frozen_hash(items[i]->pair.key, items[i]->key_len, frozen->seed);
+        }
+        built = frozen_pilots(frozen, hashes, n);
+    }
+
+    if(!built) {
+        fprintf(stderr, "Failed to freeze the table.\n");
+        if(frozen != NULL) {
+            free(frozen->pilots);
+            free(frozen->remap);
+            free(frozen->entries);
+            free(frozen->keys);
+            free(frozen);
+        }
+        free(hashes);
+        free(items);
+        return false;
+    }
+
+    // move the records to their slots and the keys to one block
+    size_t key_offset = 0;
+    for(size_t i = 0; i < n; i++) {
+        htab_frozen_entry_t *entry = &frozen->entries[frozen_index(frozen, n, hashes[i])];
+        memcpy(frozen->keys + key_offset, items[i]->pair.key, items[i]->key_len + 1);
+        entry->pair.key = frozen->keys + key_offset;
+        entry->pair.value = items[i]->pair.value;
+        entry->key_len = items[i]->key_len;
+        key_offset += items[i]->key_len + 1;
+    }
+    free(hashes);
+    free(items);
+
+    // the chains are not needed anymore, htab_clear would reset the size and counters
+    htab_items_free(t);
+
+    t->frozen = frozen;
+    return true;
+}
+
+/**
+ * @brief finds the key in the frozen table, exactly one record is compared
+ * 
+ * @param t frozen hash table
+ * @param key key of the record, does not have to be null terminated
+ * @param len length of the key
+ * @return htab_pair_t* pointer to the record
+ * @return NULL if the key was not found
+ */
+htab_pair_t * htab_frozen_find(const htab_t * t, const char *key, size_t len) {
+    const htab_frozen_t *frozen = t->frozen;
+    HTAB_COUNT(t, lookups, 1);
+    if(t->size == 0) {
+        return NULL;
+    }
+
+    htab_frozen_entry_t *entry = &frozen->entries[frozen_index(frozen, t->size, frozen_hash(key, len, frozen->seed))];
+    HTAB_COUNT(t, key_compares, 1);
+    if(entry->key_len == len && memcmp(entry->pair.key, key, len) == 0) {
+        HTAB_COUNT(t, hits, 1);
+        return &entry->pair;
+    }
+    return NULL;
+}
+
+/**
+ * @brief frees the frozen form, the table is left empty
+ * 
+ * @param t hash table
+ */
+void htab_frozen_free(htab_t * t) {
+    if(t->frozen != NULL) {
+        free(t->frozen->pilots);
+        free(t->frozen->remap);
+        free(t->frozen->entries);
+        free(t->frozen->keys);
+        free(t->frozen);
+        t->frozen = NULL;
+    }
+}
+
+/**
+ * @brief converts the frozen table back to the chains
+ * 
+ * @param t frozen hash table
+ * @return true if the records are in the chains now
+ * @return false if there is not enough memory, the table stays frozen
+ */
+bool htab_frozen_thaw(htab_t * t) {
+    const htab_frozen_t *frozen = t->frozen;
+
+    for(int i = 0; i < t->size; i++) {
+        const htab_frozen_entry_t *entry = &frozen->entries[i];
+        uint32_t slot;
+        htab_item_t *new_item = htab_item_new(t, entry->pair.key, entry->key_len, entry->pair.value, &slot);
+        if(new_item == NULL) {
+
+            // give back what we already converted, the frozen table is still complete
+            int size = t->size;
+            t->frozen = NULL;
+            htab_clear(t);
+            t->frozen = (htab_frozen_t *)frozen;
+            t->size = size;
+            return false;
+        }
+
+        size_t position = htab_hash_function_n(entry->pair.key, entry->key_len) % t->arr_size;
+        new_item->next = t->ptr[position];
+        t->ptr[position] = slot + 1;
+    }
+
+    htab_frozen_free(t);
+    return true;
+}
@@ -0,0 +1,26 @@
+/* htab_hash_function_n.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include <stdint.h>
+#include "htab.h"
+
+/**
+ * @brief calculates the hash of the string given by pointer and length,
+ * the result is the same as htab_hash_function for the null terminated string
+ * 
+ * @param str string, does not have to be null terminated
+ * @param len length of the string
+ * @return size_t hash
+ */
+size_t htab_hash_function_n(const char *str, size_t len) {
+    uint32_t h=0;     // has to be 32 bits
+    const unsigned char *p = (const unsigned char*)str;
+    for(size_t i = 0; i < len; i++)
+        h = 65599*h + p[i];
+    return h;
+}
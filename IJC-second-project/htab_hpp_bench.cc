@@ -0,0 +1,157 @@
+// htab_hpp_bench.cc
+// Solution IJC-DU2, task b)
+// Author: Adam Běhoun, FIT
+// Date: 17.4.2024
+// login: xbehoua00
+// Compiled: g++ (GCC) 10.5.0
+//
+// Compares ijc::htab with std::unordered_map on the wordcount workload.
+// The input is read from stdin once and split into words, then both tables
+// count the same words, so only the table itself is measured. The second case is
+// a generated text with a large vocabulary (about a million distinct words),
+// where the tables have to grow far beyond the cache.
+// The baseline looks the word up without allocating and creates the std::string key
+// only for a new word. Heterogeneous find(string_view) needs C++20 (and libstdc++ 11),
+// so the key is assigned to one reused buffer, which allocates only when it grows.
+// The map that builds a new std::string for every word is shown too, for reference.
+// Usage: ./htab-hpp-bench [repetitions] < file
+
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "htab.hpp"
+
+namespace {
+
+// splits the text the same way read_word does
+std::vector<std::string_view> split(const std::string &text) {
+    std::vector<std::string_view> words;
+    std::size_t i = 0;
+    while (i < text.size()) {
+        while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i])))
+            i++;
+        std::size_t start = i;
+        while (i < text.size() && !std::isspace(static_cast<unsigned char>(text[i])))
+            i++;
+        if (i > start)
+            words.emplace_back(text.data() + start, i - start);
+    }
+    return words;
+}
+
+// runs f repetitions times and returns the best time in nanoseconds per word
+template <class F>
+double measure(int repetitions, std::size_t words, F &&f) {
+    double best = 0;
+    for (int r = 0; r < repetitions; r++) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / words;
+        if (r == 0 || ns < best)
+            best = ns;
+    }
+    return best;
+}
+
+// counts the words with both tables and prints the times, false if the tables disagree
+bool run(const char *name, const std::vector<std::string_view> &words, int repetitions) {
+    std::size_t map_size = 0, htab_size = 0, naive_size = 0;
+    long map_sum = 0, htab_sum = 0, naive_sum = 0;
+
+    // a new std::string for every word, allocated even when the word is found
+    double naive_ns = measure(repetitions, words.size(), [&] {
+        std::unordered_map<std::string, int> m;
+        for (std::string_view w : words)
+            m[std::string(w)]++;
+        naive_size = m.size();
+        naive_sum = 0;
+        for (auto &mi : m)
+            naive_sum += mi.second;
+    });
+
+    // the baseline: a key is allocated only when the word is inserted
+    double map_ns = measure(repetitions, words.size(), [&] {
+        std::unordered_map<std::string, int> m;
+        std::string key;
+        for (std::string_view w : words) {
+            key.assign(w.data(), w.size());
+            auto it = m.find(key);
+            if (it != m.end())
+                it->second++;
+            else
+                m.emplace(key, 1);
+        }
+        map_size = m.size();
+        map_sum = 0;
+        for (auto &mi : m)
+            map_sum += mi.second;
+    });
+
+    double htab_ns = measure(repetitions, words.size(), [&] {
+        ijc::htab<std::string, int> t;
+        for (std::string_view w : words)
+            t[w]++;
+        htab_size = t.size();
+        htab_sum = 0;
+        t.for_each([&](const auto &pair) { htab_sum += pair.value; });
+    });
+
+    if (map_size != htab_size || map_sum != htab_sum || naive_size != map_size || naive_sum != map_sum) {
+        std::fprintf(stderr, "The tables do not agree.\n");
+        return false;
+    }
+
+    std::printf("%s: words: %zu, distinct: %zu\n", name, words.size(), map_size);
+    std::printf("  std::unordered_map: %8.2f ns/word\n", map_ns);
+    std::printf("  ijc::htab:          %8.2f ns/word (%.2fx)\n", htab_ns, map_ns / htab_ns);
+    std::printf("  std::unordered_map, std::string per word: %.2f ns/word\n", naive_ns);
+    return true;
+}
+
+// text of the given number of words, drawn uniformly from a generated vocabulary
+// of random lowercase words of 4 to 12 letters
+std::string generate(std::size_t words, std::size_t vocabulary) {
+    std::mt19937_64 rng(42); // the same text on every run
+    std::vector<std::string> vocab(vocabulary);
+    for (std::string &w : vocab) {
+        std::size_t len = 4 + rng() % 9;
+        for (std::size_t i = 0; i < len; i++)
+            w.push_back(static_cast<char>('a' + rng() % 26));
+    }
+    std::string text;
+    for (std::size_t i = 0; i < words; i++) {
+        text += vocab[rng() % vocabulary];
+        text.push_back(' ');
+    }
+    return text;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    int repetitions = argc > 1 ? std::atoi(argv[1]) : 5;
+    if (repetitions <= 0)
+        repetitions = 1;
+
+    std::string text((std::istreambuf_iterator<char>(std::cin)), std::istreambuf_iterator<char>());
+    std::vector<std::string_view> words = split(text);
+    if (words.empty()) {
+        std::fprintf(stderr, "No words on the input.\n");
+        return 1;
+    }
+    if (!run("input", words, repetitions))
+        return 1;
+
+    // 3M words, about 1.5M of them distinct
+    std::string large = generate(3000000, 2000000);
+    return run("large vocabulary", split(large), repetitions < 3 ? repetitions : 3) ? 0 : 1;
+}
@@ -0,0 +1,74 @@
+/* htab_image.h
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#ifndef HTAB_IMAGE_H // prevent multiple includes
+#define HTAB_IMAGE_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "htab.h"
+
+// Snapshot file written by htab_save. Everything is addressed by offsets from the
+// start of the file, so the file can be mapped anywhere and used without parsing:
+//
+//  header | bucket starts (bucket_count + 1) | entries (size) | keys
+//
+// entries of bucket i are entries[starts[i]] .. entries[starts[i+1] - 1],
+// keys are null terminated, so pair.key can point right into the mapping.
+// The mapping itself is never written. The records handed out by htab_find live in
+// a separate array of pairs, a pair is filled from its entry at the first hit and
+// then holds the current value, so the changes stay in the process (copy on write).
+
+#define HTAB_IMAGE_MAGIC "HTABIMG"
+#define HTAB_IMAGE_VERSION 1
+
+// the hash of this string is stored in the header, a file created with a different
+// hash function is refused
+#define HTAB_IMAGE_HASH_PROBE "htab_image"
+
+typedef struct htab_image_header {
+    char magic[8];
+    uint64_t version;
+    uint64_t size;
+    uint64_t bucket_count;
+    uint64_t hash_probe;
+    uint64_t starts_offset;
+    uint64_t entries_offset;
+    uint64_t keys_offset;
+    uint64_t keys_size;
+} htab_image_header_t;
+
+typedef struct htab_image_entry {
+    uint64_t key_offset;    // from the start of the keys
+    uint32_t key_len;
+    uint32_t hash;          // htab_hash_function of the key, rejects most of the entries
+    int64_t value;
+} htab_image_entry_t;
+
+// mapped snapshot the table is served from
+typedef struct htab_image {
+    void *base;
+    size_t length;
+    const uint64_t *starts;
+    const htab_image_entry_t *entries;
+    const char *keys;
+    uint64_t keys_size;
+    htab_pair_t *pairs;     // one for every entry, key is NULL until the pair is filled
+    pthread_mutex_t lock;   // taken only to fill a pair
+} htab_image_t;
+
+// current value of the entry i, the one in the pair if it was handed out already
+static inline htab_value_t htab_image_value(const htab_image_t *image, uint64_t i) {
+    const htab_pair_t *pair = &image->pairs[i];
+    if(__atomic_load_n(&pair->key, __ATOMIC_ACQUIRE) != NULL) {
+        return pair->value;
+    }
+    return image->entries[i].value;
+}
+
+#endif // HTAB_IMAGE_H
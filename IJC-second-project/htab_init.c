@@ -20,7 +20,7 @@
  * @return htab_t* pointer to the initialized hash table
  */
 htab_t *htab_init(const size_t n) {    
-    htab_t *table = malloc(sizeof(htab_t) + n * sizeof(htab_item_t*));
+    htab_t *table = malloc(sizeof(htab_t) + n * sizeof(uint32_t));
     if(table == NULL) { // check of successful allocation
         fprintf(stderr, "Allocation was not successful.\n");
         return NULL;
@@ -28,10 +28,37 @@ htab_t *htab_init(const size_t n) {
 
     table->size = 0;
     table->arr_size = n;
+    table->counters = NULL;
+    table->image = NULL;
+    table->frozen = NULL;
+    table->pool = NULL;
+    table->item_size = HTAB_ITEM_SIZE;
+    table->used = 0;
+    table->free_slot = 0;
+    table->key_bytes = 0;
+    for(size_t k = 0; k < HTAB_CHUNKS; k++) {
+        table->chunks[k] = NULL;
+    }
     
     for(size_t i = 0; i < n; i++) {
-        table->ptr[i] = NULL;
+        table->ptr[i] = 0;
     } 
 
+    return table;
+}
+
+/**
+ * @brief initialize hash table of size n, which takes its keys from the pool
+ * 
+ * @param n number of buckets
+ * @param pool pool of the keys, has to outlive the table
+ * @return htab_t* pointer to the initialized hash table
+ */
+htab_t *htab_init_pooled(const size_t n, htab_pool_t *pool) {
+    htab_t *table = htab_init(n);
+    if(table != NULL) {
+        table->pool = pool;
+        table->item_size = sizeof(htab_item_t); // the key is in the pool
+    }
     return table;
 }
\ No newline at end of file
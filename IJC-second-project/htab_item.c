@@ -0,0 +1,145 @@
+/* htab_item.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "htab_struct.h"
+
+/**
+ * @brief takes a slot for a new item: an erased one if there is some,
+ * otherwise the one behind the end of the dense array
+ * 
+ * @param t hash table
+ * @param slot where to store the slot
+ * @return htab_item_t* the item in the slot
+ * @return NULL if the chunk could not be allocated
+ */
+static htab_item_t *item_slot(htab_t * t, uint32_t *slot) {
+    if(t->free_slot != 0) {
+        *slot = t->free_slot - 1;
+        htab_item_t *item = htab_slot(t, *slot);
+        t->free_slot = item->next;
+        return item;
+    }
+
+    size_t k = htab_slot_chunk(t->used);
+    if(k >= HTAB_CHUNKS) {
+        fprintf(stderr, "Too many records in the table.\n");
+        return NULL;
+    }
+    if(t->chunks[k] == NULL) {
+        t->chunks[k] = malloc(HTAB_CHUNK_CAPACITY(k) * t->item_size);
+        if(t->chunks[k] == NULL) {
+            return NULL;
+        }
+    }
+    *slot = t->used++;
+    return htab_slot(t, *slot);
+}
+
+/**
+ * @brief creates a new item with copy of the key. Short keys are stored in the item
+ * itself, so the lookups do not follow another pointer to a different cache line.
+ * A pooled table only references the key, it has to come from its pool.
+ * 
+ * @param t hash table
+ * @param key key of the record, does not have to be null terminated
+ * @param len length of the key
+ * @param value initial value
+ * @param slot where to store the slot of the item
+ * @return htab_item_t* new item with next set to 0
+ * @return NULL if the allocation failed
+ */
+htab_item_t *htab_item_new(htab_t * t, const char *key, size_t len, htab_value_t value, uint32_t *slot) {
+    if(len > UINT32_MAX) {
+        fprintf(stderr, "The key is too long.\n");
+        return NULL;
+    }
+
+    const char *item_key = key;
+    char *new_key = NULL;
+    if(t->pool == NULL && len >= HTAB_INLINE_KEY) {
+        // create new variable so hash table does not store one and the same as we pass more keys
+        new_key = malloc((len+1) * sizeof(char));
+        if(new_key == NULL) {
+            fprintf(stderr, "Allocation of new item was not succesfull.\n");
+            return NULL;
+        }
+        t->key_bytes += len + 1;
+    }
+
+    htab_item_t *new_item = item_slot(t, slot);
+    if(new_item == NULL) {
+        fprintf(stderr, "Allocation of new item was not succesfull.\n");
+        if(new_key != NULL) {
+            t->key_bytes -= len + 1;
+            free(new_key);
+        }
+        return NULL;
+    }
+
+    if(t->pool == NULL) {
+        new_key = new_key != NULL ? new_key : new_item->inline_key;
+        memcpy(new_key, key, len);
+        new_key[len] = '\0'; // the key may point into a bigger buffer, so terminate it ourselves
+        item_key = new_key;
+    }
+
+    new_item->pair.key = item_key;
+    new_item->pair.value = value;
+    new_item->key_len = (uint32_t)len;
+    new_item->next = 0;
+    return new_item;
+}
+
+/**
+ * @brief frees the key of the item and puts its slot to the list of free slots,
+ * the item has to be unlinked from its chain already
+ * 
+ * @param t hash table
+ * @param slot slot of the item
+ */
+void htab_item_free(htab_t * t, uint32_t slot) {
+    htab_item_t *item = htab_slot(t, slot);
+    if(t->pool == NULL && item->pair.key != item->inline_key) {
+        t->key_bytes -= item->key_len + 1;
+        free((char*)item->pair.key);
+    }
+    item->pair.key = NULL; // the scans skip it
+    item->next = t->free_slot;
+    t->free_slot = slot + 1;
+}
+
+/**
+ * @brief frees all the items, the dense array is passed sequentially for the long keys
+ * 
+ * @param t hash table
+ */
+void htab_items_free(htab_t * t) {
+    if(t->pool == NULL) {
+        size_t slot = 0;
+        htab_item_t *item;
+        while((item = htab_item_next(t, &slot, t->used)) != NULL) {
+            if(item->pair.key != item->inline_key) {
+                free((char*)item->pair.key);
+            }
+        }
+    }
+
+    for(size_t k = 0; k < HTAB_CHUNKS; k++) {
+        free(t->chunks[k]);
+        t->chunks[k] = NULL;
+    }
+    t->used = 0;
+    t->free_slot = 0;
+    t->key_bytes = 0;
+
+    for(int i = 0; i < t->arr_size; i++) {
+        t->ptr[i] = 0;
+    }
+}
@@ -1,4 +1,4 @@
-/* htab_item.c
+/* htab_item.h
  * Solution IJC-DU2, task b)
  * Author: Adam Běhoun, FIT
  * Date: 17.4.2024
@@ -9,11 +9,42 @@
 #ifndef HTAB_ITEM_H // prevent multiple includes
 #define HTAB_ITEM_H
 
+#include <stdint.h>
 #include "htab.h"
 
+// keys shorter than this are stored right in the item, without another allocation,
+// pair.key then points to inline_key. Most of the words in a text are this short.
+#define HTAB_INLINE_KEY 24
+
+// The items are not allocated one by one, they are stored in one dense array in the order
+// they were added. The array is split into chunks of growing size (16, 32, 64, ... items),
+// so it never moves and the pair pointers stay valid. The chains link the items by their
+// positions (slots), the buckets are small arrays of slots too.
+// An erased item is marked by pair.key == NULL and its slot is reused by the next new item.
 typedef struct htab_item {
+    uint32_t next;      // slot of the next item in the chain + 1, 0 ends the chain
+    uint32_t key_len;   // length of pair.key without the null terminator
     htab_pair_t pair;
-    struct htab_item *next;
+    char inline_key[];  // HTAB_INLINE_KEY characters, not allocated for pooled keys
 } htab_item_t;
 
+// size of the item with the inline key
+#define HTAB_ITEM_SIZE (sizeof(htab_item_t) + HTAB_INLINE_KEY)
+
+// the first chunk holds 2^HTAB_CHUNK_BITS items, every next one twice as many
+#define HTAB_CHUNK_BITS 4
+// enough chunks for almost 2^32 slots
+#define HTAB_CHUNKS 28
+// first slot of the chunk k and the number of its items
+#define HTAB_CHUNK_START(k) ((((size_t)1 << (k)) - 1) << HTAB_CHUNK_BITS)
+#define HTAB_CHUNK_CAPACITY(k) ((size_t)1 << ((k) + HTAB_CHUNK_BITS))
+
+// creates the item with a copy of the key in a free slot, a pooled table only references the key.
+// The slot is stored to *slot, next is set to 0. Returns NULL if the allocation failed.
+htab_item_t *htab_item_new(htab_t * t, const char *key, size_t len, htab_value_t value, uint32_t *slot);
+// frees the key of the item if it was not inline and not pooled, the slot is kept for the next item
+void htab_item_free(htab_t * t, uint32_t slot);
+// frees all the items and their chunks, the buckets are emptied
+void htab_items_free(htab_t * t);
+
 #endif // HTAB_ITEM_H
@@ -0,0 +1,56 @@
+/* htab_iter_begin.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include <stdint.h>
+#include "htab_struct.h"
+
+/**
+ * @brief sets the cursor to the part of the dense array of records between slots from and to,
+ * cursors over disjoint ranges can be used by different threads at once. A loaded snapshot
+ * or a frozen table is converted to the chains first, so the cursors have to be set
+ * before the threads start.
+ * 
+ * @param t hash table
+ * @param it cursor to initialize
+ * @param from first slot of the range
+ * @param to slot after the last one of the range, it is cut to the slot count
+ */
+void htab_iter_range(htab_t * t, htab_iter_t *it, size_t from, size_t to) {
+    // the cursor returns the records themselves, a loaded snapshot has to be converted.
+    // If it fails, the range is left empty.
+    if(htab_readonly(t) && !htab_thaw(t)) {
+        from = to = 0;
+    }
+
+    size_t used = t->used;
+    it->t = t;
+    it->end = to < used ? to : used;
+    it->slot = from < it->end ? from : it->end;
+}
+
+/**
+ * @brief returns the number of slots of the dense array, the erased records
+ * that were not replaced yet included, so the ranges of the cursors can be split
+ * 
+ * @param t hash table
+ * @return size_t number of slots
+ */
+size_t htab_slot_count(const htab_t * t) {
+    // the conversion of a snapshot or a frozen table fills the slots without gaps
+    return htab_readonly(t) ? (size_t)t->size : t->used;
+}
+
+/**
+ * @brief sets the cursor to the beginning of the whole table
+ * 
+ * @param t hash table
+ * @param it cursor to initialize
+ */
+void htab_iter_begin(htab_t * t, htab_iter_t *it) {
+    htab_iter_range(t, it, 0, SIZE_MAX);
+}
@@ -0,0 +1,45 @@
+/* htab_iter_next.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include "htab_struct.h"
+
+/**
+ * @brief returns the next record of the cursor and moves it forward
+ * 
+ * @param it cursor set by htab_iter_begin or htab_iter_range
+ * @return htab_pair_t* the record in the table
+ * @return NULL if there are no more records in the range
+ */
+htab_pair_t * htab_iter_next(htab_iter_t *it) {
+    // erased records are skipped
+    htab_item_t *temp = htab_item_next(it->t, &it->slot, it->end);
+    return temp != NULL ? &temp->pair : NULL;
+}
+
+/**
+ * @brief fills the array with next records of the cursor, so the caller can process
+ * them in a tight loop without a call per record
+ * 
+ * @param it cursor set by htab_iter_begin or htab_iter_range
+ * @param out array for pointers to the records
+ * @param n size of the array
+ * @return size_t number of stored records, 0 if there are no more records
+ */
+size_t htab_iter_next_batch(htab_iter_t *it, htab_pair_t **out, size_t n) {
+    size_t slot = it->slot;
+    size_t count = 0;
+
+    // the same as htab_iter_next, only the cursor is kept in a local variable
+    htab_item_t *temp;
+    while(count < n && (temp = htab_item_next(it->t, &slot, it->end)) != NULL) {
+        out[count++] = &temp->pair;
+    }
+
+    it->slot = slot;
+    return count;
+}
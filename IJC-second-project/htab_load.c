@@ -0,0 +1,244 @@
+/* htab_load.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "htab_struct.h"
+
+/**
+ * @brief checks the bucket starts and the entries of the mapped snapshot, so the lookups,
+ * htab_for_each and the conversion can trust the offsets
+ * 
+ * @param header header of the snapshot, already checked
+ * @return true if every bucket and every key lies inside the file
+ */
+static bool image_valid(const htab_image_header_t *header) {
+    const char *base = (const char *)header;
+    const uint64_t *starts = (const uint64_t *)(base + header->starts_offset);
+    const htab_image_entry_t *entries = (const htab_image_entry_t *)(base + header->entries_offset);
+    const char *keys = base + header->keys_offset;
+
+    if(starts[0] != 0 || starts[header->bucket_count] != header->size) {
+        return false;
+    }
+    for(uint64_t i = 0; i < header->bucket_count; i++) {
+        if(starts[i + 1] < starts[i]) {
+            return false;
+        }
+    }
+    // the key and its terminating null have to fit, written so that nothing overflows
+    for(uint64_t i = 0; i < header->size; i++) {
+        const htab_image_entry_t *entry = &entries[i];
+        if(entry->key_offset >= header->keys_size
+                || entry->key_len >= header->keys_size - entry->key_offset
+                || keys[entry->key_offset + entry->key_len] != '\0') {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief maps the snapshot written by htab_save and returns the table served from it.
+ * The bucket starts and the entries are checked once here, a corrupted file is refused.
+ * 
+ * @param path file name
+ * @return htab_t* loaded table or NULL if something went wrong
+ */
+htab_t *htab_load(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        fprintf(stderr, "Failed to open file %s.\n", path);
+        return NULL;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(htab_image_header_t)) {
+        fprintf(stderr, "File %s is not a htab snapshot.\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    // shared mapping, so all the processes reading the snapshot use the same pages
+    void *base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(base == MAP_FAILED) {
+        fprintf(stderr, "Failed to map file %s.\n", path);
+        return NULL;
+    }
+
+    const htab_image_header_t *header = base;
+    size_t length = st.st_size;
+    bool valid = memcmp(header->magic, HTAB_IMAGE_MAGIC, sizeof(HTAB_IMAGE_MAGIC)) == 0
+        && header->version == HTAB_IMAGE_VERSION
+        && header->bucket_count > 0 && header->bucket_count <= INT32_MAX && header->size <= INT32_MAX
+        && header->starts_offset == sizeof(htab_image_header_t)
+        && header->entries_offset == header->starts_offset + (header->bucket_count + 1) * sizeof(uint64_t)
+        && header->keys_offset == header->entries_offset + header->size * sizeof(htab_image_entry_t)
+        && header->keys_size <= length && header->keys_offset + header->keys_size == length
+        && image_valid(header);
+    if(!valid) {
+        fprintf(stderr, "File %s is not a htab snapshot.\n", path);
+        munmap(base, length);
+        return NULL;
+    }
+    if(header->hash_probe != htab_hash_function(HTAB_IMAGE_HASH_PROBE)) {
+        fprintf(stderr, "Snapshot %s was created with a different hash function.\n", path);
+        munmap(base, length);
+        return NULL;
+    }
+
+    // the bucket array is needed only after the conversion, calloc of large
+    // sizes gets zero pages from the system, so they are not touched until then
+    htab_t *table = calloc(1, sizeof(htab_t) + header->bucket_count * sizeof(uint32_t));
+    htab_image_t *image = malloc(sizeof(htab_image_t));
+    // the pairs are filled only at the hits, so like the buckets they stay untouched zero pages
+    htab_pair_t *pairs = calloc(header->size > 0 ? header->size : 1, sizeof(htab_pair_t));
+    if(table == NULL || image == NULL || pairs == NULL || pthread_mutex_init(&image->lock, NULL) != 0) {
+        fprintf(stderr, "Allocation was not successful.\n");
+        free(table);
+        free(image);
+        free(pairs);
+        munmap(base, length);
+        return NULL;
+    }
+
+    image->base = base;
+    image->length = length;
+    image->starts = (const uint64_t *)((const char *)base + header->starts_offset);
+    image->entries = (const htab_image_entry_t *)((const char *)base + header->entries_offset);
+    image->keys = (const char *)base + header->keys_offset;
+    image->keys_size = header->keys_size;
+    image->pairs = pairs;
+
+    table->size = header->size;
+    table->arr_size = header->bucket_count;
+    table->counters = NULL;
+    table->image = image;
+    table->frozen = NULL;
+    table->pool = NULL;
+    table->item_size = HTAB_ITEM_SIZE; // the chunks stay unallocated until the conversion
+    return table;
+}
+
+/**
+ * @brief returns the pair of the entry, it is filled from the entry at the first call.
+ * The key is published last, so the threads that see it see the value too.
+ * 
+ * @param image mapped snapshot
+ * @param i index of the entry
+ * @return htab_pair_t* pair of the entry
+ */
+static htab_pair_t *image_pair(htab_image_t *image, uint64_t i) {
+    htab_pair_t *pair = &image->pairs[i];
+    if(__atomic_load_n(&pair->key, __ATOMIC_ACQUIRE) == NULL) {
+        pthread_mutex_lock(&image->lock);
+        if(pair->key == NULL) {
+            const htab_image_entry_t *entry = &image->entries[i];
+            pair->value = entry->value;
+            __atomic_store_n(&pair->key, image->keys + entry->key_offset, __ATOMIC_RELEASE);
+        }
+        pthread_mutex_unlock(&image->lock);
+    }
+    return pair;
+}
+
+/**
+ * @brief finds the key in the mapped snapshot
+ * 
+ * @param t loaded hash table
+ * @param hash hash of the key
+ * @param key key of the record, does not have to be null terminated
+ * @param len length of the key
+ * @return htab_pair_t* record of the key, it can be changed and stays valid until
+ * the table is converted to the memory
+ * @return NULL if the key was not found
+ */
+htab_pair_t * htab_image_find(const htab_t * t, size_t hash, const char *key, size_t len) {
+    htab_image_t *image = t->image;
+    size_t position = hash % t->arr_size;
+    uint64_t end = image->starts[position + 1];
+    size_t compares = 0;
+
+    HTAB_COUNT(t, lookups, 1);
+    for(uint64_t i = image->starts[position]; i < end; i++) {
+        const htab_image_entry_t *entry = &image->entries[i];
+        compares ++;
+        if(entry->hash == (uint32_t)hash && entry->key_len == len
+                && memcmp(image->keys + entry->key_offset, key, len) == 0) {
+            HTAB_COUNT(t, hits, 1);
+            HTAB_COUNT(t, key_compares, compares);
+            return image_pair(image, i);
+        }
+    }
+
+    HTAB_COUNT(t, key_compares, compares);
+    return NULL;
+}
+
+/**
+ * @brief unmaps the snapshot, the table is left empty
+ * 
+ * @param t loaded hash table
+ */
+void htab_image_free(htab_t * t) {
+    if(t->image != NULL) {
+        munmap(t->image->base, t->image->length);
+        pthread_mutex_destroy(&t->image->lock);
+        free(t->image->pairs);
+        free(t->image);
+        t->image = NULL;
+    }
+}
+
+/**
+ * @brief converts the loaded snapshot to the table in memory with the same buckets
+ * and order of the records and with the current values, then the snapshot is unmapped
+ * 
+ * @param t loaded hash table
+ * @return true if the table is in memory now
+ * @return false if there is not enough memory, the snapshot stays
+ */
+bool htab_image_thaw(htab_t * t) {
+    const htab_image_t *image = t->image;
+    if(image == NULL) {
+        return true;
+    }
+
+    for(int i = 0; i < t->arr_size; i++) {
+        // the chunks never move, so the link stays valid while new items are added
+        uint32_t *link = &t->ptr[i];
+        for(uint64_t j = image->starts[i]; j < image->starts[i + 1]; j++) {
+            const htab_image_entry_t *entry = &image->entries[j];
+            uint32_t slot;
+            htab_item_t *new_item = htab_item_new(t, image->keys + entry->key_offset, entry->key_len, htab_image_value(image, j), &slot);
+            if(new_item == NULL) {
+
+                // give back what we already converted, the snapshot is still complete
+                int size = t->size;
+                t->size = 0;
+                t->image = NULL;
+                htab_clear(t);
+                t->image = (htab_image_t *)image;
+                t->size = size;
+                return false;
+            }
+
+            *link = slot + 1;
+            link = &new_item->next;
+        }
+    }
+
+    htab_image_free(t);
+    return true;
+}
@@ -12,58 +12,111 @@
 #include "htab_struct.h"
 
 /**
- * @brief Search for record with key, and if it is found then returns pointer to it.
- * If it is not found, create a new record with the key, and connect it to the hash table.
+ * @brief Search for record with already hashed key of given length, and if it is found
+ * then returns pointer to it. If it is not found, create a new record with copy of the key
+ * and value 0, and connect it to the hash table. The value is not changed, that is up to the caller.
  * 
  * @param t hash table
- * @param key key of the record
+ * @param hash hash of the key
+ * @param key key of the record, does not have to be null terminated
+ * @param len length of the key
+ * @param created set to true if the record was created, false if it was found
  * @return htab_pair_t* pointer to the record
  * @return NULL if something went wrong
  */
-htab_pair_t * htab_lookup_add(htab_t * t, htab_key_t key) {
-    
-    // calculate the position using hash function and modulo
-    size_t position = htab_hash_function(key) % t->arr_size;
+htab_pair_t * htab_lookup_insert_hashed(htab_t * t, size_t hash, const char *key, size_t len, bool *created) {
+    *created = false;
+
+    // existing records of a snapshot or a frozen table can still be changed in place
+    if(htab_readonly(t)) {
+        htab_pair_t *found = t->image != NULL ? htab_image_find(t, hash, key, len) : htab_frozen_find(t, key, len);
+        if(found != NULL) {
+            return found;
+        }
+    }
+
+    // the snapshot and the frozen table are converted before the first new key
+    if(htab_readonly(t) && !htab_thaw(t)) {
+        return NULL;
+    }
 
-    htab_item_t *temp = t->ptr[position];
+    // the key is interned first, then only the pointers are compared
+    if(t->pool != NULL && (key = htab_pool_intern_hashed(t->pool, hash, key, len)) == NULL) {
+        return NULL;
+    }
+
+    // calculate the position using modulo
+    size_t position = hash % t->arr_size;
+
+    htab_item_t *temp = htab_chain(t, t->ptr[position]);
     htab_item_t *previous = NULL;
+    size_t compares = 0; // counted locally and stored once at the end
     while(temp != NULL) {
-        if(strcmp(temp->pair.key, key) == 0) {
-            temp->pair.value ++;
+        compares ++;
+        if(htab_item_match(t, temp, key, len)) {
+            HTAB_COUNT(t, lookups, 1);
+            HTAB_COUNT(t, hits, 1);
+            HTAB_COUNT(t, key_compares, compares);
             return &temp->pair;
         } else {
             previous = temp; // store the current item
-            temp = temp->next; // go to next item in table
+            temp = htab_chain(t, temp->next); // go to next item in table
         }
     }
 
-    htab_item_t *new_item = malloc(sizeof(htab_item_t));
-    if(new_item == NULL) {
-        fprintf(stderr, "Allocation of new item was not succesfull.\n");
-        return NULL;
-    }
+    HTAB_COUNT(t, lookups, 1);
+    HTAB_COUNT(t, key_compares, compares);
 
-    // create new variable so hash table does not store one and the same as we pass more keys
-    char *new_key = malloc((strlen(key)+1) * sizeof(char));
-    if(new_key == NULL) {
-        fprintf(stderr, "Allocation of new item was not succesfull.\n");
-        free(new_item);
+    // the key is copied, short keys right into the item, a pooled key is only referenced.
+    // The item is placed to the dense array, previous does not move meanwhile.
+    uint32_t slot;
+    htab_item_t *new_item = htab_item_new(t, key, len, 0, &slot);
+    if(new_item == NULL) {
         return NULL;
     }
-    strcpy(new_key, key);
-    new_item->pair.key = new_key;
-
-    new_item->pair.value = 1; // set the value to 1
-    new_item->next = NULL; // set the next pointer to NULL
-
 
     if(previous == NULL) {
         // if it is first item on the position, make it a head in the list
-        t->ptr[position] = new_item;
+        t->ptr[position] = slot + 1;
     } else {
-        previous->next = new_item; // set the previous item to point to new item
+        previous->next = slot + 1; // set the previous item to point to new item
     }
 
     t->size ++; //increment the number of records
+    HTAB_COUNT(t, inserts, 1);
+    *created = true;
     return &new_item->pair;
+} // htab_lookup_insert_hashed
+
+/**
+ * @brief Search for record with already hashed key of given length, and if it is found
+ * then increments its value. If it is not found, create a new record with value 1.
+ * 
+ * @param t hash table
+ * @param hash hash of the key
+ * @param key key of the record, does not have to be null terminated
+ * @param len length of the key
+ * @return htab_pair_t* pointer to the record
+ * @return NULL if something went wrong
+ */
+htab_pair_t * htab_lookup_add_hashed(htab_t * t, size_t hash, const char *key, size_t len) {
+    bool created;
+    htab_pair_t *pair = htab_lookup_insert_hashed(t, hash, key, len, &created);
+    if(pair != NULL) {
+        pair->value ++; // new records start at 0, so they end up with 1
+    }
+    return pair;
+} // htab_lookup_add_hashed
+
+/**
+ * @brief Search for record with key, and if it is found then returns pointer to it.
+ * If it is not found, create a new record with the key, and connect it to the hash table.
+ * 
+ * @param t hash table
+ * @param key key of the record
+ * @return htab_pair_t* pointer to the record
+ * @return NULL if something went wrong
+ */
+htab_pair_t * htab_lookup_add(htab_t * t, htab_key_t key) {
+    return htab_lookup_add_hashed(t, htab_hash_function(key), key, strlen(key));
 } // htab_lookup_add
\ No newline at end of file
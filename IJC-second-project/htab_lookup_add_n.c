@@ -0,0 +1,24 @@
+/* htab_lookup_add_n.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include "htab_struct.h"
+
+/**
+ * @brief same as htab_lookup_add, but the key is given as pointer and length,
+ * so it can point directly into an input buffer. The key is copied only when
+ * a new record is created.
+ * 
+ * @param t hash table
+ * @param key key of the record, does not have to be null terminated
+ * @param len length of the key
+ * @return htab_pair_t* pointer to the record
+ * @return NULL if something went wrong
+ */
+htab_pair_t * htab_lookup_add_n(htab_t * t, const char *key, size_t len) {
+    return htab_lookup_add_hashed(t, htab_hash_function_n(key, len), key, len);
+}
@@ -0,0 +1,70 @@
+/* htab_merge.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include "htab_struct.h"
+
+/**
+ * @brief adds one record of src to dst
+ * 
+ * @param dst hash table the record is added to
+ * @param key key of the record
+ * @param len length of the key
+ * @param value value added to the record in dst
+ * @return true if the record was added
+ */
+static inline bool merge_record(htab_t * dst, const char *key, size_t len, htab_value_t value) {
+    bool created;
+    htab_pair_t *pair = htab_lookup_insert_hashed(dst, htab_hash_function_n(key, len), key, len, &created);
+    if(pair == NULL) {
+        return false;
+    }
+    pair->value += value;
+    return true;
+}
+
+/**
+ * @brief adds the records of src to dst, the values of the keys present in both
+ * tables are summed. The keys are taken with their lengths, so keys with '\0'
+ * inside are merged exactly as they were counted. A loaded snapshot or a frozen
+ * table is read in place, src is not changed in any form.
+ * 
+ * @param dst hash table the records are added to
+ * @param src hash table the records are taken from, it is not changed
+ * @return true if all the records were added
+ * @return false if the allocation of a record failed, dst then has only part of them
+ */
+bool htab_merge(htab_t * dst, const htab_t * src) {
+    if(src->image != NULL) {
+        const htab_image_t *image = src->image;
+        for(int i = 0; i < src->size; i++) {
+            const htab_image_entry_t *entry = &image->entries[i];
+            if(!merge_record(dst, image->keys + entry->key_offset, entry->key_len, htab_image_value(image, i))) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if(src->frozen != NULL) {
+        for(int i = 0; i < src->size; i++) {
+            const htab_frozen_entry_t *entry = &src->frozen->entries[i];
+            if(!merge_record(dst, entry->pair.key, entry->key_len, entry->pair.value)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t slot = 0;
+    htab_item_t *temp;
+    while((temp = htab_item_next(src, &slot, src->used)) != NULL) {
+        if(!merge_record(dst, temp->pair.key, temp->key_len, temp->pair.value)) {
+            return false;
+        }
+    }
+    return true;
+}
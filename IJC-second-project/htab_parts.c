@@ -0,0 +1,167 @@
+/* htab_parts.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "htab_struct.h"
+
+// joined keys up to this length are built on the stack
+#define PARTS_STACK_KEY 512
+
+/**
+ * @brief hash of the key a + sep + b from the hashes of a and b, the same as
+ * htab_hash_function_n of the joined key: h(a sep b) = (h(a)*65599 + sep)*65599^len(b) + h(b)
+ * 
+ * @param hash hash of the first part (a), it can be joined from more parts already
+ * @param sep separator
+ * @param part_hash hash of the appended part (b)
+ * @param part_len length of the appended part
+ * @return size_t hash of the joined key
+ */
+size_t htab_hash_append(size_t hash, char sep, size_t part_hash, size_t part_len) {
+    // 65599^part_len by squaring, the hash has 32 bits, so the powers are taken modulo 2^32
+    uint32_t power = 1;
+    uint32_t base = 65599;
+    for(size_t e = part_len; e > 0; e >>= 1) {
+        if(e & 1) {
+            power *= base;
+        }
+        base *= base;
+    }
+    uint32_t h = (uint32_t)hash * 65599 + (unsigned char)sep;
+    return (uint32_t)(h * power + (uint32_t)part_hash);
+}
+
+/**
+ * @brief compares the key of the item with the parts joined by sep, without joining them
+ * 
+ * @param item item of the table
+ * @param parts parts of the key
+ * @param lens their lengths
+ * @param n number of the parts
+ * @param sep separator
+ * @param len length of the joined key
+ * @return true if the keys are equal
+ */
+static bool parts_match(const htab_item_t *item, const char *const *parts, const size_t *lens,
+                        size_t n, char sep, size_t len) {
+    if(item->key_len != len) {
+        return false;
+    }
+    const char *key = item->pair.key;
+    for(size_t i = 0; i < n; i++) {
+        if(i > 0 && *key++ != sep) {
+            return false;
+        }
+        if(memcmp(key, parts[i], lens[i]) != 0) {
+            return false;
+        }
+        key += lens[i];
+    }
+    return true;
+}
+
+/**
+ * @brief copies the parts joined by sep to the buffer
+ * 
+ * @param buffer where to join them, at least as long as the joined key
+ * @param parts parts of the key
+ * @param lens their lengths
+ * @param n number of the parts
+ * @param sep separator
+ */
+static void parts_join(char *buffer, const char *const *parts, const size_t *lens, size_t n, char sep) {
+    for(size_t i = 0; i < n; i++) {
+        if(i > 0) {
+            *buffer++ = sep;
+        }
+        memcpy(buffer, parts[i], lens[i]);
+        buffer += lens[i];
+    }
+}
+
+/**
+ * @brief htab_lookup_add for the key made of the parts joined by sep (e.g. a n-gram of words).
+ * The chain is searched by comparing the parts, the joined key is built only for a new record.
+ * A pooled, loaded or frozen table gets the joined key right away, they need it whole.
+ * 
+ * @param t hash table
+ * @param hash hash of the joined key, htab_hash_append gives it from the hashes of the parts
+ * @param parts parts of the key, do not have to be null terminated
+ * @param lens their lengths
+ * @param n number of the parts, at least 1
+ * @param sep separator put between the parts
+ * @return htab_pair_t* pointer to the record, its value is incremented
+ * @return NULL if something went wrong
+ */
+htab_pair_t * htab_lookup_add_parts(htab_t * t, size_t hash, const char *const *parts, const size_t *lens,
+                                    size_t n, char sep) {
+    if(n == 0) {
+        return NULL;
+    }
+    size_t len = n - 1;
+    for(size_t i = 0; i < n; i++) {
+        len += lens[i];
+    }
+
+    htab_pair_t *pair = NULL;
+    size_t position = hash % t->arr_size;
+    htab_item_t *previous = NULL;
+    bool whole = htab_readonly(t) || t->pool != NULL;
+    if(!whole) {
+        htab_item_t *temp = htab_chain(t, t->ptr[position]);
+        size_t compares = 0;
+        while(temp != NULL) {
+            compares ++;
+            if(parts_match(temp, parts, lens, n, sep, len)) {
+                HTAB_COUNT(t, lookups, 1);
+                HTAB_COUNT(t, hits, 1);
+                HTAB_COUNT(t, key_compares, compares);
+                temp->pair.value ++;
+                return &temp->pair;
+            }
+            previous = temp;
+            temp = htab_chain(t, temp->next);
+        }
+        HTAB_COUNT(t, lookups, 1);
+        HTAB_COUNT(t, key_compares, compares);
+    }
+
+    // the key is needed whole now
+    char stack_key[PARTS_STACK_KEY];
+    char *key = len <= PARTS_STACK_KEY ? stack_key : malloc(len);
+    if(key == NULL) {
+        fprintf(stderr, "Allocation of new item was not succesfull.\n");
+        return NULL;
+    }
+    parts_join(key, parts, lens, n, sep);
+
+    if(whole) {
+        pair = htab_lookup_add_hashed(t, hash, key, len);
+    } else {
+        // the chain was searched already, the new item goes to its end
+        uint32_t slot;
+        htab_item_t *new_item = htab_item_new(t, key, len, 1, &slot);
+        if(new_item != NULL) {
+            if(previous == NULL) {
+                t->ptr[position] = slot + 1;
+            } else {
+                previous->next = slot + 1;
+            }
+            t->size ++;
+            HTAB_COUNT(t, inserts, 1);
+            pair = &new_item->pair;
+        }
+    }
+
+    if(key != stack_key) {
+        free(key);
+    }
+    return pair;
+}
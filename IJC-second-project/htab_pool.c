@@ -0,0 +1,258 @@
+/* htab_pool.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "htab_pool.h"
+#include "htab_struct.h"
+
+// size of the blocks the strings are allocated from, longer strings get their own block
+#define POOL_BLOCK 65536
+
+// initial number of slots of the index, the index is at most three quarters full
+#define POOL_INDEX_INITIAL 1024
+
+typedef struct htab_pool_block {
+    struct htab_pool_block *next;
+    size_t used;
+    size_t capacity;
+    char data[];
+} htab_pool_block_t;
+
+// slot of the index, str is NULL in an empty slot
+typedef struct htab_pool_slot {
+    const char *str;
+    uint32_t hash;  // htab_hash_function_n gives 32 bits
+    uint32_t len;
+} htab_pool_slot_t;
+
+struct htab_pool {
+    htab_pool_block_t *blocks;  // the first block is the one being filled
+    htab_pool_slot_t *index;    // open addressing with linear probing
+    size_t index_size;          // power of two
+    size_t count;
+    size_t bytes;               // memory of the blocks
+};
+
+/**
+ * @brief initialize empty pool
+ * 
+ * @return htab_pool_t* pointer to the pool or NULL if the allocation failed
+ */
+htab_pool_t *htab_pool_init(void) {
+    htab_pool_t *p = malloc(sizeof(htab_pool_t));
+    if(p == NULL) {
+        fprintf(stderr, "Allocation was not successful.\n");
+        return NULL;
+    }
+    p->index = calloc(POOL_INDEX_INITIAL, sizeof(htab_pool_slot_t));
+    if(p->index == NULL) {
+        fprintf(stderr, "Allocation was not successful.\n");
+        free(p);
+        return NULL;
+    }
+    p->blocks = NULL;
+    p->index_size = POOL_INDEX_INITIAL;
+    p->count = 0;
+    p->bytes = 0;
+    return p;
+}
+
+/**
+ * @brief finds the slot of the string or the empty slot where it belongs
+ * 
+ * @param p pool
+ * @param hash hash of the string
+ * @param key string, does not have to be null terminated
+ * @param len length of the string
+ * @return htab_pool_slot_t* slot of the string or the empty one
+ */
+static htab_pool_slot_t *pool_slot(const htab_pool_t *p, size_t hash, const char *key, size_t len) {
+    size_t mask = p->index_size - 1;
+    // the low bits of htab_hash_function are weak, the multiplication moves the better ones down
+    uint32_t h = (uint32_t)hash; // only 32 bits are stored
+    size_t i = (size_t)(((uint64_t)h * 0x9e3779b97f4a7c15ULL) >> 32) & mask;
+    while(p->index[i].str != NULL) {
+        htab_pool_slot_t *slot = &p->index[i];
+        if(slot->hash == h && slot->len == len && memcmp(slot->str, key, len) == 0) {
+            return slot;
+        }
+        i = (i + 1) & mask;
+    }
+    return &p->index[i];
+}
+
+/**
+ * @brief doubles the index, the stored hashes are reused
+ * 
+ * @param p pool
+ * @return true if the index was grown
+ * @return false if the allocation failed
+ */
+static bool pool_grow(htab_pool_t *p) {
+    htab_pool_slot_t *old = p->index;
+    size_t old_size = p->index_size;
+
+    p->index = calloc(old_size * 2, sizeof(htab_pool_slot_t));
+    if(p->index == NULL) {
+        p->index = old;
+        return false;
+    }
+    p->index_size = old_size * 2;
+    for(size_t i = 0; i < old_size; i++) {
+        if(old[i].str != NULL) {
+            *pool_slot(p, old[i].hash, old[i].str, old[i].len) = old[i];
+        }
+    }
+    free(old);
+    return true;
+}
+
+/**
+ * @brief copies the string to the current block, a new block is started if it does not fit
+ * 
+ * @param p pool
+ * @param key string, does not have to be null terminated
+ * @param len length of the string
+ * @return char* null terminated copy or NULL if the allocation failed
+ */
+static char *pool_store(htab_pool_t *p, const char *key, size_t len) {
+    htab_pool_block_t *block = p->blocks;
+    if(block == NULL || block->capacity - block->used < len + 1) {
+        size_t capacity = len + 1 > POOL_BLOCK ? len + 1 : POOL_BLOCK;
+        block = malloc(sizeof(htab_pool_block_t) + capacity);
+        if(block == NULL) {
+            return NULL;
+        }
+        block->used = 0;
+        block->capacity = capacity;
+        block->next = p->blocks;
+        p->blocks = block;
+        p->bytes += sizeof(htab_pool_block_t) + capacity;
+    }
+
+    char *str = block->data + block->used;
+    memcpy(str, key, len);
+    str[len] = '\0';
+    block->used += len + 1;
+    return str;
+}
+
+/**
+ * @brief returns the interned copy of the already hashed string, it is added if it is new
+ * 
+ * @param p pool
+ * @param hash hash of the string by htab_hash_function_n
+ * @param key string, does not have to be null terminated
+ * @param len length of the string
+ * @return const char* interned copy or NULL if the allocation failed
+ */
+const char *htab_pool_intern_hashed(htab_pool_t *p, size_t hash, const char *key, size_t len) {
+    if(len > UINT32_MAX) {
+        fprintf(stderr, "The string is too long for the pool.\n");
+        return NULL;
+    }
+    htab_pool_slot_t *slot = pool_slot(p, hash, key, len);
+    if(slot->str != NULL) {
+        return slot->str;
+    }
+
+    if(4 * (p->count + 1) > 3 * p->index_size) {
+        if(!pool_grow(p)) {
+            fprintf(stderr, "Allocation of the pool index was not successful.\n");
+            return NULL;
+        }
+        slot = pool_slot(p, hash, key, len);
+    }
+
+    char *str = pool_store(p, key, len);
+    if(str == NULL) {
+        fprintf(stderr, "Allocation of the pool block was not successful.\n");
+        return NULL;
+    }
+    *slot = (htab_pool_slot_t){str, (uint32_t)hash, (uint32_t)len};
+    p->count++;
+    return str;
+}
+
+/**
+ * @brief returns the interned copy of the already hashed string
+ * 
+ * @param p pool
+ * @param hash hash of the string by htab_hash_function_n
+ * @param key string, does not have to be null terminated
+ * @param len length of the string
+ * @return const char* interned copy or NULL if the string is not in the pool
+ */
+const char *htab_pool_find_hashed(const htab_pool_t *p, size_t hash, const char *key, size_t len) {
+    return pool_slot(p, hash, key, len)->str;
+}
+
+/**
+ * @brief returns the interned copy of the string, it is added if it is new
+ * 
+ * @param p pool
+ * @param key string, does not have to be null terminated
+ * @param len length of the string
+ * @return const char* interned copy or NULL if the allocation failed
+ */
+const char *htab_pool_intern(htab_pool_t *p, const char *key, size_t len) {
+    return htab_pool_intern_hashed(p, htab_hash_function_n(key, len), key, len);
+}
+
+/**
+ * @brief returns the interned copy of the string
+ * 
+ * @param p pool
+ * @param key string, does not have to be null terminated
+ * @param len length of the string
+ * @return const char* interned copy or NULL if the string is not in the pool
+ */
+const char *htab_pool_find(const htab_pool_t *p, const char *key, size_t len) {
+    return htab_pool_find_hashed(p, htab_hash_function_n(key, len), key, len);
+}
+
+/**
+ * @brief returns the number of distinct strings in the pool
+ * 
+ * @param p pool
+ * @return size_t number of strings
+ */
+size_t htab_pool_size(const htab_pool_t *p) {
+    return p->count;
+}
+
+/**
+ * @brief returns the memory used by the pool
+ * 
+ * @param p pool
+ * @return size_t number of bytes
+ */
+size_t htab_pool_bytes(const htab_pool_t *p) {
+    return sizeof(htab_pool_t) + p->index_size * sizeof(htab_pool_slot_t) + p->bytes;
+}
+
+/**
+ * @brief frees the pool and all its strings, no table may use it anymore
+ * 
+ * @param p pool, can be NULL
+ */
+void htab_pool_free(htab_pool_t *p) {
+    if(p == NULL) {
+        return;
+    }
+    htab_pool_block_t *block = p->blocks;
+    while(block != NULL) {
+        htab_pool_block_t *next = block->next;
+        free(block);
+        block = next;
+    }
+    free(p->index);
+    free(p);
+}
@@ -0,0 +1,39 @@
+/* htab_pool.h
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#ifndef HTAB_POOL_H__ // prevent multiple includes
+#define HTAB_POOL_H__
+
+#include "htab.h"
+
+// Pool of interned strings shared by several tables. Every distinct string is stored
+// once in big blocks and the returned pointer stays valid until htab_pool_free,
+// so two strings are equal exactly when their pointers are.
+//
+// A table made by htab_init_pooled does not copy the keys, it takes them from the pool,
+// and its chains compare only pointers. The pool must outlive all its tables and is
+// not thread-safe. Strings stay in the pool when they are erased from a table.
+// The pool is indexed by htab_hash_function_n, a table with a custom
+// htab_hash_function has to be used only by the _n functions.
+
+struct htab_pool;
+typedef struct htab_pool htab_pool_t;
+
+htab_pool_t *htab_pool_init(void);
+// returns the interned copy of the string, NULL if the allocation failed
+const char *htab_pool_intern(htab_pool_t *p, const char *key, size_t len);
+// returns the interned copy or NULL if the string is not in the pool
+const char *htab_pool_find(const htab_pool_t *p, const char *key, size_t len);
+size_t htab_pool_size(const htab_pool_t *p);   // number of distinct strings
+size_t htab_pool_bytes(const htab_pool_t *p);  // memory of the pool
+void htab_pool_free(htab_pool_t *p);
+
+// table with n buckets using the keys from the pool
+htab_t *htab_init_pooled(const size_t n, htab_pool_t *pool);
+
+#endif // HTAB_POOL_H__
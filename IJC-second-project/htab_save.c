@@ -0,0 +1,220 @@
+/* htab_save.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "htab_struct.h"
+
+/**
+ * @brief fills the header of the snapshot, the sections follow it in the order of htab_image.h
+ * 
+ * @param t hash table
+ * @param keys_size bytes of all the keys with their null terminators
+ * @return htab_image_header_t header
+ */
+static htab_image_header_t save_header(const htab_t * t, uint64_t keys_size) {
+    htab_image_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, HTAB_IMAGE_MAGIC, sizeof(HTAB_IMAGE_MAGIC));
+    header.version = HTAB_IMAGE_VERSION;
+    header.size = t->size;
+    header.bucket_count = t->arr_size;
+    header.hash_probe = htab_hash_function(HTAB_IMAGE_HASH_PROBE);
+    header.starts_offset = sizeof(header);
+    header.entries_offset = header.starts_offset + (header.bucket_count + 1) * sizeof(uint64_t);
+    header.keys_offset = header.entries_offset + header.size * sizeof(htab_image_entry_t);
+    header.keys_size = keys_size;
+    return header;
+}
+
+/**
+ * @brief writes the table in the chains
+ * 
+ * @param t hash table in the chains
+ * @param f file
+ * @return true if everything was written
+ */
+static bool save_chains(const htab_t * t, FILE *f) {
+    uint64_t keys_size = 0;
+    for(int i = 0; i < t->arr_size; i++) {
+        for(htab_item_t *temp = htab_chain(t, t->ptr[i]); temp != NULL; temp = htab_chain(t, temp->next)) {
+            keys_size += temp->key_len + 1;
+        }
+    }
+
+    htab_image_header_t header = save_header(t, keys_size);
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+
+    // where the entries of every bucket start
+    uint64_t start = 0;
+    for(int i = 0; ok && i <= t->arr_size; i++) {
+        ok = fwrite(&start, sizeof(start), 1, f) == 1;
+        for(htab_item_t *temp = i < t->arr_size ? htab_chain(t, t->ptr[i]) : NULL; temp != NULL; temp = htab_chain(t, temp->next)) {
+            start ++;
+        }
+    }
+
+    // entries in the bucket order
+    uint64_t key_offset = 0;
+    for(int i = 0; ok && i < t->arr_size; i++) {
+        for(htab_item_t *temp = htab_chain(t, t->ptr[i]); ok && temp != NULL; temp = htab_chain(t, temp->next)) {
+            htab_image_entry_t entry = {
+                .key_offset = key_offset,
+                .key_len = temp->key_len,
+                .hash = htab_hash_function_n(temp->pair.key, temp->key_len),
+                .value = temp->pair.value,
+            };
+            ok = fwrite(&entry, sizeof(entry), 1, f) == 1;
+            key_offset += temp->key_len + 1;
+        }
+    }
+
+    // keys with their null terminators in the same order
+    for(int i = 0; ok && i < t->arr_size; i++) {
+        for(htab_item_t *temp = htab_chain(t, t->ptr[i]); ok && temp != NULL; temp = htab_chain(t, temp->next)) {
+            ok = fwrite(temp->pair.key, 1, temp->key_len + 1, f) == temp->key_len + 1;
+        }
+    }
+    return ok;
+}
+
+/**
+ * @brief writes the frozen table, its records are sorted to the buckets
+ * of the table by a counting sort
+ * 
+ * @param t frozen hash table
+ * @param f file
+ * @return true if everything was written
+ */
+static bool save_frozen(const htab_t * t, FILE *f) {
+    const htab_frozen_entry_t *entries = t->frozen->entries;
+    size_t n = t->size;
+    uint64_t *starts = calloc(t->arr_size + 1, sizeof(uint64_t));
+    uint32_t *hashes = malloc((n > 0 ? n : 1) * sizeof(uint32_t));
+    uint32_t *order = malloc((n > 0 ? n : 1) * sizeof(uint32_t));
+    bool ok = starts != NULL && hashes != NULL && order != NULL;
+    if(!ok) {
+        fprintf(stderr, "Allocation was not successful.\n");
+    }
+
+    uint64_t keys_size = 0;
+    for(size_t i = 0; ok && i < n; i++) {
+        hashes[i] = htab_hash_function_n(entries[i].pair.key, entries[i].key_len);
+        starts[hashes[i] % t->arr_size + 1] ++;
+        keys_size += entries[i].key_len + 1;
+    }
+    for(int i = 0; ok && i < t->arr_size; i++) {
+        starts[i + 1] += starts[i];
+    }
+    // starts[b] is moved to the end of the bucket b and back by the second pass
+    for(size_t i = 0; ok && i < n; i++) {
+        order[starts[hashes[i] % t->arr_size] ++] = i;
+    }
+    for(int i = t->arr_size; ok && i > 0; i--) {
+        starts[i] = starts[i - 1];
+    }
+    if(ok) {
+        starts[0] = 0;
+    }
+
+    htab_image_header_t header = save_header(t, keys_size);
+    ok = ok && fwrite(&header, sizeof(header), 1, f) == 1
+        && fwrite(starts, sizeof(uint64_t), t->arr_size + 1, f) == (size_t)t->arr_size + 1;
+
+    uint64_t key_offset = 0;
+    for(size_t i = 0; ok && i < n; i++) {
+        const htab_frozen_entry_t *temp = &entries[order[i]];
+        htab_image_entry_t entry = {
+            .key_offset = key_offset,
+            .key_len = temp->key_len,
+            .hash = hashes[order[i]],
+            .value = temp->pair.value,
+        };
+        ok = fwrite(&entry, sizeof(entry), 1, f) == 1;
+        key_offset += temp->key_len + 1;
+    }
+    for(size_t i = 0; ok && i < n; i++) {
+        const htab_frozen_entry_t *temp = &entries[order[i]];
+        ok = fwrite(temp->pair.key, 1, temp->key_len + 1, f) == temp->key_len + 1;
+    }
+
+    free(starts);
+    free(hashes);
+    free(order);
+    return ok;
+}
+
+/**
+ * @brief writes the loaded snapshot, the file is copied as it is,
+ * only the entries get the values changed since the loading
+ * 
+ * @param t loaded hash table
+ * @param f file
+ * @return true if everything was written
+ */
+static bool save_image(const htab_t * t, FILE *f) {
+    const htab_image_t *image = t->image;
+    const htab_image_header_t *header = image->base;
+    bool ok = fwrite(image->base, 1, header->entries_offset, f) == header->entries_offset;
+    for(int i = 0; ok && i < t->size; i++) {
+        htab_image_entry_t entry = image->entries[i];
+        entry.value = htab_image_value(image, i);
+        ok = fwrite(&entry, sizeof(entry), 1, f) == 1;
+    }
+    return ok && fwrite(image->keys, 1, image->keys_size, f) == image->keys_size;
+}
+
+/**
+ * @brief writes the snapshot of the table in the format of htab_image.h.
+ * The file is written under a temporary name and renamed at the end, so the
+ * processes that have the old snapshot mapped are not affected. Nothing is converted:
+ * a loaded snapshot is copied with its current values and a frozen table is written from its records.
+ * 
+ * @param t hash table
+ * @param path file name
+ * @return true if the snapshot was written
+ * @return false if something went wrong
+ */
+bool htab_save(const htab_t * t, const char *path) {
+    size_t path_len = strlen(path);
+    char *temp_path = malloc(path_len + sizeof(".tmp"));
+    if(temp_path == NULL) {
+        fprintf(stderr, "Allocation was not successful.\n");
+        return false;
+    }
+    memcpy(temp_path, path, path_len);
+    memcpy(temp_path + path_len, ".tmp", sizeof(".tmp"));
+
+    FILE *f = fopen(temp_path, "wb");
+    if(f == NULL) {
+        fprintf(stderr, "Failed to open file %s.\n", temp_path);
+        free(temp_path);
+        return false;
+    }
+
+    bool ok;
+    if(t->image != NULL) {
+        ok = save_image(t, f);
+    } else if(t->frozen != NULL) {
+        ok = save_frozen(t, f);
+    } else {
+        ok = save_chains(t, f);
+    }
+
+    ok = fclose(f) == 0 && ok;
+    if(ok && rename(temp_path, path) != 0) {
+        ok = false;
+    }
+    if(!ok) {
+        fprintf(stderr, "Failed to write the snapshot %s.\n", path);
+        remove(temp_path);
+    }
+
+    free(temp_path);
+    return ok;
+}
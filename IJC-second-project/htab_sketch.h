@@ -0,0 +1,47 @@
+/* htab_sketch.h
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#ifndef HTAB_SKETCH_H__ // prevent multiple includes
+#define HTAB_SKETCH_H__
+
+#include <stdint.h>
+#include "htab.h"
+
+// Approximate word counting in fixed memory, for streams whose distinct words
+// would not fit into the exact table. Every word is hashed once by htab_hash_function
+// and the hash feeds three structures:
+//  - Count-Min sketch with conservative update, the frequency of any word is
+//    overestimated by at most epsilon * total with probability 1 - delta,
+//  - HyperLogLog, the number of distinct words with relative standard error hll_error,
+//  - exact table of the k current heavy hitters (SpaceSaving), a word enters it
+//    only if the sketch estimates it above the least frequent of them.
+// The memory depends only on the parameters, never on the input.
+
+struct htab_sketch;
+typedef struct htab_sketch htab_sketch_t;
+
+// heavy hitter, count is at most error above the real frequency
+typedef struct htab_sketch_hitter {
+    const char *key;
+    uint64_t count;
+    uint64_t error;
+} htab_sketch_hitter_t;
+
+htab_sketch_t *htab_sketch_init(double epsilon, double delta, double hll_error, size_t k);
+bool htab_sketch_add(htab_sketch_t *s, const char *key, size_t len);
+
+uint64_t htab_sketch_estimate(const htab_sketch_t *s, const char *key, size_t len);
+double htab_sketch_distinct(const htab_sketch_t *s);
+uint64_t htab_sketch_total(const htab_sketch_t *s);
+// stores at most k heavy hitters in descending order, keys are valid until the next add
+size_t htab_sketch_top(const htab_sketch_t *s, htab_sketch_hitter_t *out);
+size_t htab_sketch_bytes(const htab_sketch_t *s);
+
+void htab_sketch_free(htab_sketch_t *s);
+
+#endif // HTAB_SKETCH_H__
@@ -0,0 +1,166 @@
+/* htab_sketch_add.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include "htab_sketch_struct.h"
+
+/**
+ * @brief stores the slot at position i and its position in the table record
+ * 
+ * @param s sketch
+ * @param i position in the heap
+ * @param slot slot to store
+ */
+static inline void sketch_place(htab_sketch_t *s, size_t i, htab_sketch_slot_t slot) {
+    s->slots[i] = slot;
+    slot.pair->value = (htab_value_t)i;
+}
+
+/**
+ * @brief moves the slot at position i up the min-heap
+ * 
+ * @param s sketch
+ * @param i position of the slot
+ */
+static void sketch_sift_up(htab_sketch_t *s, size_t i) {
+    htab_sketch_slot_t moved = s->slots[i];
+    while(i > 0) {
+        size_t parent = (i - 1) / 2;
+        if(s->slots[parent].count <= moved.count) {
+            break;
+        }
+        sketch_place(s, i, s->slots[parent]);
+        i = parent;
+    }
+    sketch_place(s, i, moved);
+}
+
+/**
+ * @brief moves the slot at position i down the min-heap, so the least frequent is on top
+ * 
+ * @param s sketch
+ * @param i position of the slot
+ */
+static void sketch_sift_down(htab_sketch_t *s, size_t i) {
+    htab_sketch_slot_t moved = s->slots[i];
+    while(true) {
+        size_t child = 2 * i + 1;
+        if(child >= s->used) {
+            break;
+        }
+        if(child + 1 < s->used && s->slots[child + 1].count < s->slots[child].count) {
+            child++;
+        }
+        if(s->slots[child].count >= moved.count) {
+            break;
+        }
+        sketch_place(s, i, s->slots[child]);
+        i = child;
+    }
+    sketch_place(s, i, moved);
+}
+
+/**
+ * @brief updates the heavy hitters with the word, a monitored word is incremented,
+ * a new one replaces the least frequent if the sketch estimates it higher
+ * 
+ * @param s sketch
+ * @param hash hash of the word
+ * @param key word
+ * @param len length of the word
+ * @param estimate estimate of the word from the Count-Min sketch
+ * @return true if the word was processed
+ * @return false if the allocation of a record failed
+ */
+static bool sketch_hitters_add(htab_sketch_t *s, size_t hash, const char *key, size_t len, uint64_t estimate) {
+    htab_pair_t *pair = htab_find_hashed(s->hitters, hash, key, len);
+    if(pair != NULL) {
+        size_t i = (size_t)pair->value;
+        s->slots[i].count++;
+        sketch_sift_down(s, i);
+        return true;
+    }
+
+    if(s->used < s->k) {
+        // until the table is full, every word is monitored from its first occurrence
+        bool created;
+        pair = htab_lookup_insert_hashed(s->hitters, hash, key, len, &created);
+        if(pair == NULL) {
+            return false;
+        }
+        s->slots[s->used] = (htab_sketch_slot_t){pair, hash, len, 1, 0};
+        sketch_sift_up(s, s->used++);
+        return true;
+    }
+
+    // the word may have been evicted before, so it takes over the count of
+    // the least frequent one, which bounds its real frequency from above
+    htab_sketch_slot_t *min = &s->slots[0];
+    if(estimate <= min->count) {
+        return true;
+    }
+    uint64_t count = min->count;
+    htab_erase_hashed(s->hitters, min->hash, min->pair->key, min->len);
+
+    bool created;
+    pair = htab_lookup_insert_hashed(s->hitters, hash, key, len, &created);
+    if(pair == NULL) {
+        // the least frequent word is lost, the heap gets smaller by one
+        s->slots[0] = s->slots[--s->used];
+        if(s->used > 0) {
+            sketch_sift_down(s, 0);
+        }
+        return false;
+    }
+    s->slots[0] = (htab_sketch_slot_t){pair, hash, len, count + 1, count};
+    sketch_sift_down(s, 0);
+    return true;
+}
+
+/**
+ * @brief adds one occurrence of the word to all three structures
+ * 
+ * @param s sketch
+ * @param key word, does not have to be null terminated
+ * @param len length of the word
+ * @return true if the word was added
+ * @return false if the allocation of a heavy hitter failed
+ */
+bool htab_sketch_add(htab_sketch_t *s, const char *key, size_t len) {
+    size_t hash = htab_hash_function_n(key, len);
+    uint64_t mixed = htab_sketch_mix(hash);
+    s->total++;
+
+    // HyperLogLog: the top bits select the register, the rest gives the rank
+    size_t reg = mixed >> (64 - s->precision);
+    uint64_t rest = (mixed << s->precision) | ((uint64_t)1 << (s->precision - 1));
+    uint8_t rank = (uint8_t)(__builtin_clzll(rest) + 1);
+    if(rank > s->registers[reg]) {
+        s->registers[reg] = rank;
+    }
+
+    // Count-Min with conservative update: only the smallest counters are raised
+    uint32_t estimate = UINT32_MAX;
+    for(size_t row = 0; row < s->depth; row++) {
+        uint32_t c = *htab_sketch_counter(s, mixed, row);
+        estimate = c < estimate ? c : estimate;
+    }
+    if(estimate < UINT32_MAX) {
+        estimate++;
+        for(size_t row = 0; row < s->depth; row++) {
+            uint32_t *c = htab_sketch_counter(s, mixed, row);
+            if(*c < estimate) {
+                *c = estimate;
+            }
+        }
+    }
+
+    if(s->k == 0) {
+        return true;
+    }
+    return sketch_hitters_add(s, hash, key, len, estimate);
+}
@@ -0,0 +1,98 @@
+/* htab_sketch_init.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "htab_sketch_struct.h"
+
+#define SKETCH_E 2.718281828459045
+
+/**
+ * @brief initialize the approximate counter, its memory is given only by the parameters
+ * 
+ * @param epsilon allowed overestimate of a frequency as a fraction of all words, e.g. 0.0001
+ * @param delta probability that the overestimate is larger, e.g. 0.01
+ * @param hll_error relative standard error of the distinct count, e.g. 0.01
+ * @param k number of heavy hitters kept exactly, can be 0
+ * @return htab_sketch_t* pointer to the initialized sketch or NULL if the parameters are invalid
+ */
+htab_sketch_t *htab_sketch_init(double epsilon, double delta, double hll_error, size_t k) {
+    if(!(epsilon > 0 && epsilon < 1) || !(delta > 0 && delta < 1) || !(hll_error > 0 && hll_error < 1)) {
+        fprintf(stderr, "Invalid error bounds of the sketch.\n");
+        return NULL;
+    }
+
+    htab_sketch_t *s = calloc(1, sizeof(htab_sketch_t));
+    if(s == NULL) {
+        fprintf(stderr, "Allocation was not successful.\n");
+        return NULL;
+    }
+
+    // Count-Min: width e/epsilon rounded up to a power of two, depth ln(1/delta)
+    s->width = 1;
+    while((double)s->width < SKETCH_E / epsilon) {
+        s->width <<= 1;
+    }
+    s->depth = 1;
+    for(double p = 1 / SKETCH_E; p > delta; p /= SKETCH_E) {
+        s->depth++;
+    }
+
+    // HyperLogLog: the standard error is 1.04 / sqrt(m), 16 to 2^18 registers
+    s->precision = 4;
+    while(s->precision < 18 && 1.04 * 1.04 / (double)(1u << s->precision) > hll_error * hll_error) {
+        s->precision++;
+    }
+
+    s->k = k;
+    s->counters = calloc(s->width * s->depth, sizeof(uint32_t));
+    s->registers = calloc((size_t)1 << s->precision, sizeof(uint8_t));
+    s->slots = malloc((k > 0 ? k : 1) * sizeof(htab_sketch_slot_t));
+    s->hitters = htab_init(k > 0 ? 2 * k + 1 : 1);
+    if(s->counters == NULL || s->registers == NULL || s->slots == NULL || s->hitters == NULL) {
+        fprintf(stderr, "Allocation was not successful.\n");
+        htab_sketch_free(s);
+        return NULL;
+    }
+
+    return s;
+}
+
+/**
+ * @brief returns the memory used by the sketch, the heavy hitters table included
+ * 
+ * @param s sketch
+ * @return size_t number of bytes
+ */
+size_t htab_sketch_bytes(const htab_sketch_t *s) {
+    size_t bytes = sizeof(htab_sketch_t);
+    bytes += s->width * s->depth * sizeof(uint32_t);
+    bytes += ((size_t)1 << s->precision) * sizeof(uint8_t);
+    bytes += s->k * sizeof(htab_sketch_slot_t);
+    htab_stats_t stats;
+    htab_get_stats(s->hitters, &stats);
+    return bytes + stats.bucket_bytes + stats.item_bytes + stats.key_bytes;
+}
+
+/**
+ * @brief frees the sketch and its heavy hitters
+ * 
+ * @param s sketch, can be NULL
+ */
+void htab_sketch_free(htab_sketch_t *s) {
+    if(s == NULL) {
+        return;
+    }
+    free(s->counters);
+    free(s->registers);
+    free(s->slots);
+    if(s->hitters != NULL) {
+        htab_free(s->hitters);
+    }
+    free(s);
+}
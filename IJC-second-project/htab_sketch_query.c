@@ -0,0 +1,102 @@
+/* htab_sketch_query.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include <stdlib.h>
+#include <math.h>
+#include "htab_sketch_struct.h"
+
+/**
+ * @brief estimates the frequency of the word, the result is never lower than the real one
+ * 
+ * @param s sketch
+ * @param key word, does not have to be null terminated
+ * @param len length of the word
+ * @return uint64_t estimated frequency
+ */
+uint64_t htab_sketch_estimate(const htab_sketch_t *s, const char *key, size_t len) {
+    size_t hash = htab_hash_function_n(key, len);
+    uint64_t mixed = htab_sketch_mix(hash);
+
+    uint64_t estimate = UINT32_MAX;
+    for(size_t row = 0; row < s->depth; row++) {
+        uint32_t c = *htab_sketch_counter(s, mixed, row);
+        estimate = c < estimate ? c : estimate;
+    }
+
+    // both are upper bounds, take the tighter one
+    htab_pair_t *pair = htab_find_hashed(s->hitters, hash, key, len);
+    if(pair != NULL && s->slots[pair->value].count < estimate) {
+        estimate = s->slots[pair->value].count;
+    }
+    return estimate;
+}
+
+/**
+ * @brief estimates the number of distinct words by HyperLogLog,
+ * small cardinalities are corrected by linear counting
+ * 
+ * @param s sketch
+ * @return double estimated number of distinct words
+ */
+double htab_sketch_distinct(const htab_sketch_t *s) {
+    size_t m = (size_t)1 << s->precision;
+    double sum = 0;
+    size_t zeros = 0;
+    for(size_t i = 0; i < m; i++) {
+        sum += 1.0 / (double)((uint64_t)1 << s->registers[i]);
+        zeros += s->registers[i] == 0;
+    }
+
+    double alpha = m == 16 ? 0.673 : m == 32 ? 0.697 : m == 64 ? 0.709 : 0.7213 / (1 + 1.079 / m);
+    double estimate = alpha * m * m / sum;
+    if(estimate <= 2.5 * m && zeros > 0) {
+        estimate = m * log((double)m / zeros);
+    }
+    return estimate;
+}
+
+/**
+ * @brief returns the number of added words
+ * 
+ * @param s sketch
+ * @return uint64_t number of words
+ */
+uint64_t htab_sketch_total(const htab_sketch_t *s) {
+    return s->total;
+}
+
+/**
+ * @brief orders the heavy hitters by count in descending order, then by key
+ * 
+ * @param a first heavy hitter
+ * @param b second heavy hitter
+ * @return int result of comparison for qsort
+ */
+static int sketch_hitter_cmp(const void *a, const void *b) {
+    const htab_sketch_hitter_t *x = a;
+    const htab_sketch_hitter_t *y = b;
+    if(x->count != y->count) {
+        return x->count < y->count ? 1 : -1;
+    }
+    return strcmp(x->key, y->key);
+}
+
+/**
+ * @brief stores the heavy hitters in descending order
+ * 
+ * @param s sketch
+ * @param out array of at least k heavy hitters
+ * @return size_t number of stored heavy hitters
+ */
+size_t htab_sketch_top(const htab_sketch_t *s, htab_sketch_hitter_t *out) {
+    for(size_t i = 0; i < s->used; i++) {
+        out[i] = (htab_sketch_hitter_t){s->slots[i].pair->key, s->slots[i].count, s->slots[i].error};
+    }
+    qsort(out, s->used, sizeof(htab_sketch_hitter_t), sketch_hitter_cmp);
+    return s->used;
+}
@@ -0,0 +1,57 @@
+/* htab_sketch_struct.h
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#ifndef HTAB_SKETCH_STRUCT_H // prevent multiple includes
+#define HTAB_SKETCH_STRUCT_H
+
+#include "htab_sketch.h"
+#include "htab_struct.h"
+
+// monitored word, the slots form a min-heap by count and
+// the value of the record in the table is the position of its slot
+typedef struct htab_sketch_slot {
+    htab_pair_t *pair;
+    size_t hash;
+    size_t len;
+    uint64_t count;
+    uint64_t error;
+} htab_sketch_slot_t;
+
+struct htab_sketch {
+    uint64_t total;             // number of added words
+
+    size_t width;               // counters in a row of the Count-Min sketch, power of two
+    size_t depth;               // number of rows
+    uint32_t *counters;         // depth * width, saturating
+
+    unsigned precision;         // HyperLogLog uses 2^precision registers
+    uint8_t *registers;
+
+    size_t k;                   // capacity of the heavy hitters
+    size_t used;
+    htab_t *hitters;            // exact table of the monitored words
+    htab_sketch_slot_t *slots;  // k slots
+};
+
+// htab_hash_function gives only 32 bits with weak low bits,
+// the finalizer of splitmix64 spreads them over the whole word
+static inline uint64_t htab_sketch_mix(size_t hash) {
+    uint64_t x = (uint64_t)hash + 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// counter of the row for the mixed hash, the rows use double hashing
+static inline uint32_t *htab_sketch_counter(const htab_sketch_t *s, uint64_t mixed, size_t row) {
+    uint32_t h1 = (uint32_t)mixed;
+    uint32_t h2 = (uint32_t)(mixed >> 32) | 1;
+    return &s->counters[row * s->width + ((h1 + row * h2) & (s->width - 1))];
+}
+
+#endif // htab_sketch_struct.h
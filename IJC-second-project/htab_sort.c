@@ -0,0 +1,162 @@
+/* htab_sort.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "htab_struct.h"
+
+// parts of the key sort shorter than this are sorted by insertion
+#define SORT_SMALL 32
+
+/**
+ * @brief insertion sort of records whose keys share the first depth characters
+ * 
+ * @param pairs records
+ * @param n number of records
+ * @param depth length of the common prefix
+ */
+static void sort_keys_small(htab_pair_t **pairs, size_t n, size_t depth) {
+    for(size_t i = 1; i < n; i++) {
+        htab_pair_t *moved = pairs[i];
+        size_t j = i;
+        for(; j > 0 && strcmp(pairs[j-1]->key + depth, moved->key + depth) > 0; j--) {
+            pairs[j] = pairs[j-1];
+        }
+        pairs[j] = moved;
+    }
+}
+
+/**
+ * @brief MSD radix sort by the keys: the records are distributed by the character
+ * at depth and each group is sorted by the next character. The keys that end at
+ * depth are equal, so their group is done. The order is the one of strcmp.
+ * 
+ * @param pairs records, their keys share the first depth characters
+ * @param tmp space for n records
+ * @param n number of records
+ * @param depth length of the common prefix
+ */
+static void sort_keys(htab_pair_t **pairs, htab_pair_t **tmp, size_t n, size_t depth) {
+    while(n >= SORT_SMALL) {
+        size_t count[256] = {0};
+        for(size_t i = 0; i < n; i++) {
+            count[(unsigned char)pairs[i]->key[depth]]++;
+        }
+
+        size_t start[256];
+        size_t sum = 0;
+        for(int c = 0; c < 256; c++) {
+            start[c] = sum;
+            sum += count[c];
+        }
+        for(size_t i = 0; i < n; i++) {
+            tmp[start[(unsigned char)pairs[i]->key[depth]]++] = pairs[i];
+        }
+        memcpy(pairs, tmp, n * sizeof(htab_pair_t*));
+
+        // the largest group is sorted by the loop, so the recursion stays shallow
+        // when most keys share a long prefix
+        int largest = 1;
+        for(int c = 2; c < 256; c++) {
+            largest = count[c] > count[largest] ? c : largest;
+        }
+        for(int c = 1; c < 256; c++) {
+            if(c != largest && count[c] > 1) {
+                sort_keys(pairs + start[c] - count[c], tmp, count[c], depth + 1);
+            }
+        }
+        pairs += start[largest] - count[largest];
+        n = count[largest];
+        depth++;
+    }
+    sort_keys_small(pairs, n, depth);
+}
+
+/**
+ * @brief stable LSD radix sort by the values in descending order, 8 bits per pass.
+ * The histograms of all the passes are counted at once and the passes where all
+ * the records have the same digit are skipped, so small counts take one or two passes.
+ * 
+ * @param pairs records
+ * @param tmp space for n records
+ * @param n number of records
+ */
+static void sort_values(htab_pair_t **pairs, htab_pair_t **tmp, size_t n) {
+    enum { PASSES = sizeof(htab_value_t) };
+    size_t count[PASSES][256] = {{0}};
+
+    // the order of the unsigned digits is reversed and the sign bit flipped, so the
+    // ascending sort of the digits gives the descending order of the values
+    #define SORT_DIGITS(value) (~((uint64_t)(value) ^ ((uint64_t)1 << (8 * PASSES - 1))))
+    for(size_t i = 0; i < n; i++) {
+        uint64_t digits = SORT_DIGITS(pairs[i]->value);
+        for(int pass = 0; pass < PASSES; pass++) {
+            count[pass][(digits >> (8 * pass)) & 0xff]++;
+        }
+    }
+
+    htab_pair_t **from = pairs;
+    htab_pair_t **to = tmp;
+    for(int pass = 0; pass < PASSES; pass++) {
+        size_t start[256];
+        size_t sum = 0;
+        bool trivial = false;
+        for(int c = 0; c < 256; c++) {
+            trivial = trivial || count[pass][c] == n;
+            start[c] = sum;
+            sum += count[pass][c];
+        }
+        if(trivial) {
+            continue;
+        }
+
+        for(size_t i = 0; i < n; i++) {
+            uint64_t digits = SORT_DIGITS(from[i]->value);
+            to[start[(digits >> (8 * pass)) & 0xff]++] = from[i];
+        }
+        htab_pair_t **swap = from;
+        from = to;
+        to = swap;
+    }
+    #undef SORT_DIGITS
+
+    if(from != pairs) {
+        memcpy(pairs, from, n * sizeof(htab_pair_t*));
+    }
+}
+
+/**
+ * @brief sorts an array of records, e.g. filled by htab_iter_next_batch or htab_topk.
+ * Radix sorts are used, the order by value is the one of htab_topk: the keys are
+ * sorted first and the stable sort by value keeps them in order for equal values.
+ * 
+ * @param pairs records
+ * @param n number of records
+ * @param order HTAB_ORDER_VALUE (descending, equal values by key) or HTAB_ORDER_KEY
+ * @return true if the records were sorted
+ * @return false if the allocation of the temporary array failed
+ */
+bool htab_sort(htab_pair_t **pairs, size_t n, htab_order_t order) {
+    if(n < 2) {
+        return true;
+    }
+    htab_pair_t **tmp = malloc(n * sizeof(htab_pair_t*));
+    if(tmp == NULL) {
+        fprintf(stderr, "Error: allocation of the sort.\n");
+        return false;
+    }
+
+    sort_keys(pairs, tmp, n, 0);
+    if(order == HTAB_ORDER_VALUE) {
+        sort_values(pairs, tmp, n);
+    }
+
+    free(tmp);
+    return true;
+}
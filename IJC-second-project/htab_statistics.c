@@ -14,34 +14,25 @@
  *  - min: the minimum number of records in any bucket of the hash table
  *  - max: the maximum number of records in any bucket of the hash table
  *  - avg: the average number of records of all the bucketsof the hash table
+ *  - p99: 99 % of the buckets have at most this many records
+ * When the counters are enabled, the lookups and memory usage are printed too.
  * 
  * @param t hash table
  */
 void htab_statistics(const htab_t * t) {
-    int min = 0;
-    int max = 0;
+    htab_stats_t stats;
+    htab_get_stats(t, &stats);
 
-    for(int i = 0; i < t->arr_size; i++) {
-        htab_item_t *temp = t->ptr[i];
-        int length = 0;
-        while(temp != NULL) {
-            length ++;
-            temp = temp->next;
-        }
-        max = max > length ? max : length; // update the maximum number
+    fprintf(stderr, "min: %zu\n", stats.chain_min);
+    fprintf(stderr, "max: %zu\n", stats.chain_max);
+    fprintf(stderr, "avg: %.2f\n", stats.chain_avg);
+    fprintf(stderr, "p99: %zu\n", stats.chain_p99);
 
-        if(i == 0) { // set the first number to minimum
-            min = length;
-        } else {
-            min = min > length ? length : min; // update the minimum number if the current is less
-        }
+    if(t->counters != NULL) {
+        fprintf(stderr, "lookups: %llu (hits %llu, misses %llu)\n", stats.lookups, stats.hits, stats.misses);
+        fprintf(stderr, "inserts: %llu, erases: %llu\n", stats.inserts, stats.erases);
+        fprintf(stderr, "compares per lookup: %.2f\n", stats.compares_per_lookup);
+        fprintf(stderr, "memory: %zu B buckets, %zu B items, %zu B keys\n",
+                stats.bucket_bytes, stats.item_bytes, stats.key_bytes);
     }
-
-
-    // calculate average number of records as float number
-    // we have size and arr_size as integers, so we need to convert int to float
-    float avg = (float)t->size/(float)t->arr_size;
-    fprintf(stderr, "min: %d\n", min);
-    fprintf(stderr, "max: %d\n", max);
-    fprintf(stderr, "avg: %.2f\n", avg);
-}
\ No newline at end of file
+}
@@ -0,0 +1,207 @@
+/* htab_stats.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "htab_struct.h"
+
+/**
+ * @brief enables or disables the operation counters. Enabling resets them,
+ * while disabled the operations only check one pointer.
+ * 
+ * @param t hash table
+ * @param enable true to start counting
+ */
+void htab_stats_enable(htab_t * t, bool enable) {
+    if(enable && t->counters == NULL) {
+        t->counters = calloc(1, sizeof(htab_counters_t));
+        if(t->counters == NULL) {
+            fprintf(stderr, "Allocation of counters was not successful.\n");
+        }
+    } else if(!enable) {
+        free(t->counters);
+        t->counters = NULL;
+    }
+}
+
+/**
+ * @brief length of the chain of the bucket, a loaded snapshot has it in the bucket starts
+ * 
+ * @param t hash table in the chains or loaded
+ * @param i bucket
+ * @return size_t number of records in the bucket
+ */
+static inline size_t stats_chain_length(const htab_t * t, int i) {
+    if(t->image != NULL) {
+        return t->image->starts[i + 1] - t->image->starts[i];
+    }
+    size_t length = 0;
+    for(htab_item_t *temp = htab_chain(t, t->ptr[i]); temp != NULL; temp = htab_chain(t, temp->next)) {
+        length ++;
+    }
+    return length;
+}
+
+/**
+ * @brief finds the p99 length of chains longer than the histogram covers,
+ * the exact lengths are counted in the second pass over the table
+ * 
+ * @param t hash table
+ * @param max length of the longest chain
+ * @param skip number of buckets that are shorter than the histogram limit
+ * @param wanted number of buckets the p99 length has to cover
+ * @return size_t p99 length
+ */
+static size_t stats_long_p99(const htab_t * t, size_t max, size_t skip, size_t wanted) {
+    size_t *counts = calloc(max + 1, sizeof(size_t));
+    if(counts == NULL) {
+        return max; // upper bound is still a valid answer
+    }
+
+    for(int i = 0; i < t->arr_size; i++) {
+        counts[stats_chain_length(t, i)] ++;
+    }
+
+    size_t covered = skip;
+    size_t p99 = max;
+    for(size_t length = HTAB_STATS_HISTOGRAM - 1; length <= max; length++) {
+        covered += counts[length];
+        if(covered >= wanted) {
+            p99 = length;
+            break;
+        }
+    }
+
+    free(counts);
+    return p99;
+}
+
+/**
+ * @brief fills the chain lengths and memory usage of the table in the chains
+ * or of the loaded snapshot, its buckets are read in place
+ * 
+ * @param t hash table
+ * @param stats structure to fill
+ */
+static void stats_chains(const htab_t * t, htab_stats_t *stats) {
+    stats->size = t->size;
+    stats->bucket_count = t->arr_size;
+
+    for(int i = 0; i < t->arr_size; i++) {
+        size_t length = stats_chain_length(t, i);
+
+        stats->chain_max = stats->chain_max > length ? stats->chain_max : length;
+        stats->chain_min = (i == 0 || length < stats->chain_min) ? length : stats->chain_min;
+        stats->chain_histogram[length < HTAB_STATS_HISTOGRAM ? length : HTAB_STATS_HISTOGRAM - 1] ++;
+    }
+    stats->chain_avg = t->arr_size > 0 ? (double)t->size / t->arr_size : 0.0;
+
+    // the smallest length that covers 99 % of the buckets
+    size_t wanted = (stats->bucket_count * 99 + 99) / 100;
+    size_t covered = 0;
+    for(size_t length = 0; length < HTAB_STATS_HISTOGRAM - 1; length++) {
+        covered += stats->chain_histogram[length];
+        if(covered >= wanted) {
+            stats->chain_p99 = length;
+            break;
+        }
+    }
+    if(covered < wanted) {
+        stats->chain_p99 = stats_long_p99(t, stats->chain_max, covered, wanted);
+    }
+
+    stats->bucket_bytes = sizeof(htab_t) + t->arr_size * sizeof(uint32_t);
+    if(t->image != NULL) {
+        // the mapping: bucket starts, entries and keys
+        stats->bucket_bytes += (t->arr_size + 1) * sizeof(uint64_t);
+        stats->item_bytes = t->size * sizeof(htab_image_entry_t);
+        stats->key_bytes = t->image->keys_size;
+        return;
+    }
+    // copies of the long keys, short keys are inside the items
+    stats->key_bytes = t->key_bytes;
+    // the allocated chunks of the dense array, free slots included,
+    // pooled items have no inline key, their keys are counted by htab_pool_bytes
+    for(size_t k = 0; k < HTAB_CHUNKS && t->chunks[k] != NULL; k++) {
+        stats->item_bytes += HTAB_CHUNK_CAPACITY(k) * t->item_size;
+    }
+}
+
+/**
+ * @brief fills the statistics of the frozen table, it has one slot for every record and no chains
+ * 
+ * @param t frozen hash table
+ * @param stats structure to fill
+ */
+static void stats_frozen(const htab_t * t, htab_stats_t *stats) {
+    const htab_frozen_t *frozen = t->frozen;
+    size_t n = t->size;
+
+    stats->size = n;
+    stats->bucket_count = n;
+    stats->chain_min = stats->chain_max = stats->chain_p99 = n > 0 ? 1 : 0;
+    stats->chain_avg = n > 0 ? 1.0 : 0.0;
+    stats->chain_histogram[n > 0 ? 1 : 0] = n;
+
+    stats->bucket_bytes = sizeof(htab_t) + t->arr_size * sizeof(uint32_t) + sizeof(htab_frozen_t)
+        + frozen->bucket_count * sizeof(uint16_t) + (frozen->slot_count - n) * sizeof(uint32_t);
+    stats->item_bytes = n * sizeof(htab_frozen_entry_t);
+    for(size_t i = 0; i < n; i++) {
+        stats->key_bytes += frozen->entries[i].key_len + 1;
+    }
+}
+
+/**
+ * @brief collects the statistics of the table: chain lengths, operation counters
+ * and memory usage. Takes one pass over the table.
+ * 
+ * @param t hash table
+ * @param stats structure to fill
+ */
+void htab_get_stats(const htab_t * t, htab_stats_t *stats) {
+    memset(stats, 0, sizeof(htab_stats_t));
+
+    if(t->frozen != NULL) {
+        stats_frozen(t, stats);
+    } else {
+        stats_chains(t, stats);
+    }
+
+    if(t->counters != NULL) {
+        htab_counters_t *counters = t->counters;
+        stats->lookups = atomic_load_explicit(&counters->lookups, memory_order_relaxed);
+        stats->hits = atomic_load_explicit(&counters->hits, memory_order_relaxed);
+        // the counters are read one by one while other threads may be counting
+        stats->misses = stats->lookups > stats->hits ? stats->lookups - stats->hits : 0;
+        stats->inserts = atomic_load_explicit(&counters->inserts, memory_order_relaxed);
+        stats->erases = atomic_load_explicit(&counters->erases, memory_order_relaxed);
+        stats->key_compares = atomic_load_explicit(&counters->key_compares, memory_order_relaxed);
+        stats->compares_per_lookup = stats->lookups > 0 ? (double)stats->key_compares / stats->lookups : 0.0;
+    }
+}
+
+/**
+ * @brief memory taken by the table, the same as the sum of the bytes of htab_get_stats,
+ * but the table in memory keeps the size of its long keys, so no record is visited
+ * 
+ * @param t hash table
+ * @return size_t number of bytes
+ */
+size_t htab_memory(const htab_t * t) {
+    if(htab_readonly(t)) {
+        htab_stats_t stats;
+        htab_get_stats(t, &stats);
+        return stats.bucket_bytes + stats.item_bytes + stats.key_bytes;
+    }
+
+    size_t bytes = sizeof(htab_t) + t->arr_size * sizeof(uint32_t) + t->key_bytes;
+    for(size_t k = 0; k < HTAB_CHUNKS && t->chunks[k] != NULL; k++) {
+        bytes += HTAB_CHUNK_CAPACITY(k) * t->item_size;
+    }
+    return bytes;
+}
@@ -9,13 +9,134 @@
 #ifndef HTAB_STRUCT_H // prevent multiple includes
 #define HTAB_STRUCT_H
 
+#include <stdatomic.h>
 #include "htab.h"
 #include "htab_item.h"
+#include "htab_image.h"
+#include "htab_pool.h"
+
+// operation counters, allocated only when they are enabled. htab_find takes a const
+// table and may run in more threads at once, so the counters are atomic, added relaxed.
+typedef struct htab_counters {
+    atomic_ullong lookups;
+    atomic_ullong hits;
+    atomic_ullong inserts;
+    atomic_ullong erases;
+    atomic_ullong key_compares;
+} htab_counters_t;
+
+// record of the frozen table
+typedef struct htab_frozen_entry {
+    htab_pair_t pair;
+    size_t key_len;
+} htab_frozen_entry_t;
+
+// minimal perfect hash built by htab_freeze: the key selects a bucket, the pilot
+// of the bucket selects a slot. Slots behind the number of records are remapped
+// to the free ones in front, so every record has exactly one slot.
+typedef struct htab_frozen {
+    uint64_t seed;
+    size_t bucket_count;
+    size_t slot_count;
+    uint16_t *pilots;               // one for every bucket
+    uint32_t *remap;                // slot_count - size entries
+    htab_frozen_entry_t *entries;   // size entries
+    char *keys;                     // all the keys, null terminated
+} htab_frozen_t;
 
 struct htab {
     int size;
     int arr_size;
-    htab_item_t *ptr[];
+    htab_counters_t *counters; // NULL when the counters are disabled
+    htab_image_t *image; // snapshot the table is served from, NULL for the table in memory
+    htab_frozen_t *frozen; // read only form made by htab_freeze, NULL if not frozen
+    htab_pool_t *pool; // pool the keys are taken from, NULL if the table copies them itself
+    size_t item_size; // HTAB_ITEM_SIZE, pooled items have no inline key
+    uint32_t used; // slots of the dense array taken so far, erased ones included
+    uint32_t free_slot; // first erased slot + 1, the others are linked by next, 0 if there is none
+    size_t key_bytes; // copies of the keys too long for the item, so htab_memory does not walk them
+    char *chunks[HTAB_CHUNKS]; // parts of the dense array, allocated when they are reached
+    uint32_t ptr[]; // slot of the first item in the bucket + 1, 0 for an empty bucket
 };
 
+// chunk of the dense array the slot is in
+static inline size_t htab_slot_chunk(size_t slot) {
+    return 63 - __builtin_clzll(((unsigned long long)slot >> HTAB_CHUNK_BITS) + 1);
+}
+
+// item in the slot
+static inline htab_item_t *htab_slot(const htab_t * t, size_t slot) {
+    size_t k = htab_slot_chunk(slot);
+    return (htab_item_t *)(t->chunks[k] + (slot - HTAB_CHUNK_START(k)) * t->item_size);
+}
+
+// item the link (bucket head or next) points to, NULL at the end of the chain
+static inline htab_item_t *htab_chain(const htab_t * t, uint32_t link) {
+    return link != 0 ? htab_slot(t, link - 1) : NULL;
+}
+
+// first item in use at the position *slot or behind it, but before end.
+// *slot is moved behind the returned item, NULL is returned at the end.
+// This is how the full scans stream over the dense array in the order of insertion.
+static inline htab_item_t *htab_item_next(const htab_t * t, size_t *slot, size_t end) {
+    while(*slot < end) {
+        size_t k = htab_slot_chunk(*slot);
+        size_t chunk_end = HTAB_CHUNK_START(k) + HTAB_CHUNK_CAPACITY(k);
+        chunk_end = chunk_end < end ? chunk_end : end;
+        char *p = t->chunks[k] + (*slot - HTAB_CHUNK_START(k)) * t->item_size;
+        for(; *slot < chunk_end; p += t->item_size) {
+            (*slot)++;
+            if(((htab_item_t *)p)->pair.key != NULL) {
+                return (htab_item_t *)p;
+            }
+        }
+    }
+    return NULL;
+}
+
+// adds n to the counter, the check is predicted as not taken, so it costs next to nothing when disabled
+#define HTAB_COUNT(t, counter, n) do { \
+        if(__builtin_expect((t)->counters != NULL, 0)) \
+            atomic_fetch_add_explicit(&(t)->counters->counter, (n), memory_order_relaxed); \
+    } while(0)
+
+// true if the records are not in the chains, but in a snapshot or a frozen table
+static inline bool htab_readonly(const htab_t * t) {
+    return __builtin_expect(t->image != NULL || t->frozen != NULL, 0);
+}
+
+// pooled keys are compared by the pointer, the caller replaces the key by the interned copy first
+static inline bool htab_item_match(const htab_t * t, const htab_item_t *item, const char *key, size_t len) {
+    if(t->pool != NULL) {
+        return item->pair.key == key;
+    }
+    // compare the lengths first, so we don't touch the key memory needlessly
+    return item->key_len == len && memcmp(item->pair.key, key, len) == 0;
+}
+
+// pool lookups with the hash already computed by the table
+const char *htab_pool_intern_hashed(htab_pool_t *p, size_t hash, const char *key, size_t len);
+const char *htab_pool_find_hashed(const htab_pool_t *p, size_t hash, const char *key, size_t len);
+
+// converts a snapshot or a frozen table back to the chains,
+// returns false if there is not enough memory, then the table stays as it was
+bool htab_thaw(htab_t * t);
+
+// snapshot support: lookup in the mapped file, conversion to the chains and unmapping
+htab_pair_t * htab_image_find(const htab_t * t, size_t hash, const char *key, size_t len);
+bool htab_image_thaw(htab_t * t);
+void htab_image_free(htab_t * t);
+
+// frozen table support: lookup, conversion to the chains and freeing
+htab_pair_t * htab_frozen_find(const htab_t * t, const char *key, size_t len);
+bool htab_frozen_thaw(htab_t * t);
+void htab_frozen_free(htab_t * t);
+
+// internal cores shared by the null-terminated and the (ptr, len) variants,
+// the caller computes the hash with the matching hash function
+htab_pair_t * htab_find_hashed(const htab_t * t, size_t hash, const char *key, size_t len);
+htab_pair_t * htab_lookup_add_hashed(htab_t * t, size_t hash, const char *key, size_t len);
+htab_pair_t * htab_lookup_insert_hashed(htab_t * t, size_t hash, const char *key, size_t len, bool *created);
+bool htab_erase_hashed(htab_t * t, size_t hash, const char *key, size_t len);
+
 #endif // htab_struct.h
\ No newline at end of file
@@ -0,0 +1,27 @@
+/* htab_thaw.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include "htab_struct.h"
+
+/**
+ * @brief converts the loaded snapshot or the frozen table back to the chains,
+ * so it can be changed or traversed through the records
+ * 
+ * @param t hash table
+ * @return true if the records are in the chains now
+ * @return false if there is not enough memory, the table stays as it was
+ */
+bool htab_thaw(htab_t * t) {
+    if(t->image != NULL) {
+        return htab_image_thaw(t);
+    }
+    if(t->frozen != NULL) {
+        return htab_frozen_thaw(t);
+    }
+    return true;
+}
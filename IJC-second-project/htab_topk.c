@@ -0,0 +1,104 @@
+/* htab_topk.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include "htab_struct.h"
+
+/**
+ * @brief decides which record ranks lower, the lower value loses and
+ * equal values are ordered by key, so the result does not depend on the table layout
+ * 
+ * @param a first record
+ * @param b second record
+ * @return true if a ranks lower than b
+ */
+static inline bool topk_lower(const htab_pair_t *a, const htab_pair_t *b) {
+    if(a->value != b->value) {
+        return a->value < b->value;
+    }
+    return strcmp(a->key, b->key) > 0;
+}
+
+/**
+ * @brief moves the record at position i down the min-heap, so the lowest ranked is on top
+ * 
+ * @param heap array of records
+ * @param n number of records in the heap
+ * @param i position of the record
+ */
+static void topk_sift_down(htab_pair_t **heap, size_t n, size_t i) {
+    htab_pair_t *moved = heap[i];
+    while(true) {
+        size_t child = 2 * i + 1;
+        if(child >= n) {
+            break;
+        }
+        // take the lower ranked of the children
+        if(child + 1 < n && topk_lower(heap[child + 1], heap[child])) {
+            child++;
+        }
+        if(!topk_lower(heap[child], moved)) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = moved;
+}
+
+/**
+ * @brief finds k records with the highest values in one sequential pass over the records.
+ * The array out itself is used as a min-heap of the best records seen so far,
+ * a record enters only if it ranks higher than the heap top. A loaded snapshot
+ * or a frozen table is converted to the chains first, that is why t is not const.
+ * 
+ * @param t hash table
+ * @param k number of wanted records
+ * @param out array of at least k pointers, the records are stored in descending order
+ * @return size_t number of stored records, smaller than k if the table has less records
+ */
+size_t htab_topk(htab_t * t, size_t k, htab_pair_t **out) {
+    // the result points to the records, a loaded snapshot or a frozen table has to be converted
+    if(k == 0 || (htab_readonly(t) && !htab_thaw(t))) {
+        return 0;
+    }
+
+    size_t count = 0;
+    size_t slot = 0;
+    htab_item_t *temp;
+    while((temp = htab_item_next(t, &slot, t->used)) != NULL) {
+        htab_pair_t *pair = &temp->pair;
+
+        if(count < k) {
+            // fill the heap first, sift up the new record
+            size_t position = count++;
+            while(position > 0) {
+                size_t parent = (position - 1) / 2;
+                if(!topk_lower(pair, out[parent])) {
+                    break;
+                }
+                out[position] = out[parent];
+                position = parent;
+            }
+            out[position] = pair;
+        } else if(topk_lower(out[0], pair)) {
+            // most of the records end here with one comparison
+            out[0] = pair;
+            topk_sift_down(out, k, 0);
+        }
+    }
+
+    // heap sort, the lowest ranked record goes to the end each time
+    for(size_t n = count; n > 1; n--) {
+        htab_pair_t *lowest = out[0];
+        out[0] = out[n - 1];
+        out[n - 1] = lowest;
+        topk_sift_down(out, n - 1, 0);
+    }
+
+    return count;
+}
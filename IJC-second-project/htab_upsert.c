@@ -0,0 +1,52 @@
+/* htab_upsert.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include "htab_struct.h"
+
+/**
+ * @brief finds the record or creates a new one with value 0, the caller then
+ * updates the value as it needs, all with one traversal of the list
+ * 
+ * @param t hash table
+ * @param key key of the record, does not have to be null terminated
+ * @param len length of the key
+ * @param created set to true if the record was created, false if it was found
+ * @return htab_pair_t* pointer to the record
+ * @return NULL if something went wrong
+ */
+htab_pair_t * htab_lookup_insert_n(htab_t * t, const char *key, size_t len, bool *created) {
+    return htab_lookup_insert_hashed(t, htab_hash_function_n(key, len), key, len, created);
+}
+
+/**
+ * @brief generalized htab_lookup_add: the new record is set by init, the found one
+ * by update, so any aggregation (sum, max, ...) takes one traversal of the list
+ * 
+ * @param t hash table
+ * @param key key of the record, does not have to be null terminated
+ * @param len length of the key
+ * @param init called for the new record, its value is 0 before, can be NULL
+ * @param update called for the found record, can be NULL
+ * @param ctx passed to init and update
+ * @return htab_pair_t* pointer to the record
+ * @return NULL if something went wrong
+ */
+htab_pair_t * htab_upsert(htab_t * t, const char *key, size_t len,
+                          void (*init)(htab_pair_t *data, void *ctx),
+                          void (*update)(htab_pair_t *data, void *ctx), void *ctx) {
+    bool created;
+    htab_pair_t *pair = htab_lookup_insert_n(t, key, len, &created);
+    if(pair != NULL) {
+        if(created && init != NULL) {
+            init(pair, ctx);
+        } else if(!created && update != NULL) {
+            update(pair, ctx);
+        }
+    }
+    return pair;
+}
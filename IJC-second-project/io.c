@@ -6,7 +6,19 @@
  * Compiled: gcc (GCC) 10.5.0
 */
 
+#define _POSIX_C_SOURCE 200809L
 
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "io.h"
 
 /**
@@ -44,4 +56,728 @@ int read_word(char *s, int max, FILE *f) {
     }
 
     return position;
-} // read_word
\ No newline at end of file
+} // read_word
+
+// the block is followed by this many spaces, so whole 16 byte groups can be loaded
+#define IO_PADDING 16
+
+/**
+ * @brief returns the mask of whitespace characters among 16 bytes, the same ones
+ * as isspace in the "C" locale: space, \t, \n, \v, \f and \r
+ * 
+ * @param p first of the bytes
+ * @return unsigned bit i is set if p[i] is whitespace
+ */
+static inline unsigned space_mask(const char *p) {
+#ifdef __SSE2__
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    __m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+    // \t to \r are 9 to 13, after subtracting 9 they are the only bytes not above 4
+    __m128i x = _mm_sub_epi8(v, _mm_set1_epi8(9));
+    __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8(4)), x);
+    return (unsigned)_mm_movemask_epi8(_mm_or_si128(space, control));
+#else
+    unsigned mask = 0;
+    for(int i = 0; i < 16; i++) {
+        unsigned char c = p[i];
+        mask |= (unsigned)(c == ' ' || (c >= '\t' && c <= '\r')) << i;
+    }
+    return mask;
+#endif
+}
+
+/**
+ * @brief finds the first whitespace character, the spaces behind the data stop the search
+ * 
+ * @param p where to start
+ * @return char* the whitespace character
+ */
+static inline char *find_space(char *p) {
+    while(true) {
+        unsigned mask = space_mask(p);
+        if(mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+}
+
+/**
+ * @brief skips the whitespace characters
+ * 
+ * @param p where to start
+ * @param end end of the data
+ * @return char* first other character or end
+ */
+static inline char *skip_space(char *p, char *end) {
+    while(p < end) {
+        unsigned mask = ~space_mask(p) & 0xffff;
+        if(mask != 0) {
+            p += __builtin_ctz(mask);
+            return p < end ? p : end;
+        }
+        p += 16;
+    }
+    return end;
+}
+
+/**
+ * @brief reads the next part of the input behind the data in the block
+ * 
+ * @param r reader
+ */
+static void reader_fill(io_reader_t *r) {
+    size_t read = fread(r->data + r->len, 1, IO_BLOCK - r->len, r->f);
+    r->eof = r->len + read < IO_BLOCK; // fread returns less only at the end or on error
+    r->len += read;
+    memset(r->data + r->len, ' ', IO_PADDING);
+}
+
+/**
+ * @brief prepares the reader of words from the stream
+ * 
+ * @param r reader to initialize
+ * @param f stream
+ * @param max the words are cut to max-1 characters
+ * @return true if the reader is ready
+ * @return false if the allocation failed
+ */
+bool io_reader_init(io_reader_t *r, FILE *f, int max) {
+    r->f = f;
+    r->max = max;
+    r->data = malloc(IO_BLOCK + IO_PADDING);
+    r->word = malloc(max);
+    r->pos = r->len = 0;
+    r->eof = false;
+    r->cut = false;
+    if(r->data == NULL || r->word == NULL) {
+        fprintf(stderr, "Allocation of the input buffer was not successful.\n");
+        io_reader_free(r);
+        return false;
+    }
+    memset(r->data, ' ', IO_PADDING);
+    return true;
+}
+
+/**
+ * @brief reads the rest of a word that is longer than the block, the beginning is kept in r->word
+ * 
+ * @param r reader
+ * @param start the word in the block
+ * @param len length of the word in the block, at least max-1
+ * @return size_t length of the cut word
+ */
+static size_t reader_long_word(io_reader_t *r, char *start, size_t len) {
+    size_t cut = r->max - 1;
+    memcpy(r->word, start, cut);
+    // a word of exactly max-1 characters is cut only if it goes on in the next block
+    r->cut = len > cut;
+
+    // skip the remaining characters
+    do {
+        r->pos = r->len = 0;
+        reader_fill(r);
+        r->pos = find_space(r->data) - r->data;
+        r->cut = r->cut || r->pos > 0;
+    } while(r->pos == r->len && !r->eof);
+    return cut;
+}
+
+/**
+ * @brief finds the next words in the block, the block is read again when it is used up,
+ * but only if no word was found in this call yet, so all the returned words stay valid
+ * 
+ * @param r reader
+ * @param words where to store the words
+ * @param lens where to store their lengths, at most max-1
+ * @param n size of the arrays
+ * @return size_t number of the found words, 0 at the end of the input
+ */
+size_t io_read_words(io_reader_t *r, const char **words, size_t *lens, size_t n) {
+    size_t count = 0;
+    size_t cut = r->max - 1;
+    r->cut = false;
+
+    while(count < n) {
+        char *end = r->data + r->len;
+        char *start = skip_space(r->data + r->pos, end);
+        r->pos = start - r->data;
+        if(start == end) {
+            if(r->eof || count > 0) {
+                break;
+            }
+            r->pos = r->len = 0;
+            reader_fill(r);
+            continue;
+        }
+
+        char *stop = find_space(start);
+        size_t len = stop - start;
+        if(stop == end && !r->eof) {
+            // the word may continue in the next block
+            if(count > 0) {
+                break;
+            }
+            if(len >= cut) {
+                words[count] = r->word;
+                lens[count++] = reader_long_word(r, start, len);
+                break;
+            }
+            memmove(r->data, start, len);
+            r->pos = 0;
+            r->len = len;
+            reader_fill(r);
+            continue;
+        }
+
+        if(len > cut) {
+            len = cut;
+            r->cut = true;
+        }
+        words[count] = start;
+        lens[count++] = len;
+        r->pos = stop - r->data;
+    }
+    return count;
+}
+
+/**
+ * @brief frees the buffers of the reader
+ * 
+ * @param r reader
+ */
+void io_reader_free(io_reader_t *r) {
+    free(r->data);
+    free(r->word);
+    r->data = r->word = NULL;
+}
+
+/**
+ * @brief true for the whitespace characters of space_mask
+ * 
+ * @param c character
+ * @return true if c is whitespace
+ */
+static inline bool is_space(char c) {
+    unsigned char u = c;
+    return u == ' ' || (u >= '\t' && u <= '\r');
+}
+
+/**
+ * @brief stores up to n next words of the memory between *p and end, only whole
+ * 16 byte groups are loaded, the rest is checked one by one
+ * 
+ * @param p where to start, moved behind the last returned word
+ * @param end end of the memory
+ * @param max the words are cut to max-1 characters
+ * @param words where to store the words
+ * @param lens where to store their lengths
+ * @param n size of the arrays
+ * @param cut set to true if some word was cut, left as it was otherwise
+ * @return size_t number of the found words, 0 at the end
+ */
+size_t io_scan_words(const char **p, const char *end, int max, const char **words, size_t *lens, size_t n, bool *cut) {
+    const char *q = *p;
+    size_t count = 0;
+    size_t limit = max - 1;
+
+    while(count < n) {
+        // skip the whitespace
+        while(q + 16 <= end) {
+            unsigned mask = ~space_mask(q) & 0xffff;
+            if(mask != 0) {
+                q += __builtin_ctz(mask);
+                break;
+            }
+            q += 16;
+        }
+        while(q < end && is_space(*q)) {
+            q++;
+        }
+        if(q == end) {
+            break;
+        }
+
+        // find the end of the word
+        const char *start = q;
+        while(q + 16 <= end) {
+            unsigned mask = space_mask(q);
+            if(mask != 0) {
+                q += __builtin_ctz(mask);
+                goto found;
+            }
+            q += 16;
+        }
+        while(q < end && !is_space(*q)) {
+            q++;
+        }
+    found:;
+        size_t len = q - start;
+        if(len > limit) {
+            len = limit;
+            *cut = true;
+        }
+        words[count] = start;
+        lens[count++] = len;
+    }
+
+    *p = q;
+    return count;
+}
+
+/**
+ * @brief creates the output buffer
+ * 
+ * @param w writer
+ * @param fd file descriptor to write to
+ * @return true if the buffer was allocated
+ * @return false if the allocation failed
+ */
+bool io_writer_init(io_writer_t *w, int fd) {
+    w->fd = fd;
+    w->len = 0;
+    w->error = false;
+    w->data = malloc(IO_WRITE_BLOCK);
+    if(w->data == NULL) {
+        fprintf(stderr, "Error: allocation of the output buffer.\n");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief passes the buffer to write(), which may take only part of it at once
+ * 
+ * @param w writer
+ * @return true if everything was written
+ * @return false if a write failed, the rest of the output is dropped
+ */
+bool io_writer_flush(io_writer_t *w) {
+    size_t done = 0;
+    while(!w->error && done < w->len) {
+        ssize_t count = write(w->fd, w->data + done, w->len - done);
+        if(count < 0 && errno != EINTR) {
+            w->error = true;
+        } else if(count > 0) {
+            done += count;
+        }
+    }
+    w->len = 0;
+    return !w->error;
+}
+
+/**
+ * @brief appends the bytes to the buffer, flushes it as many times as needed
+ * 
+ * @param w writer
+ * @param s bytes, do not have to be null terminated
+ * @param len number of the bytes
+ */
+void io_write(io_writer_t *w, const char *s, size_t len) {
+    while(len > IO_WRITE_BLOCK - w->len) {
+        size_t part = IO_WRITE_BLOCK - w->len;
+        memcpy(w->data + w->len, s, part);
+        w->len = IO_WRITE_BLOCK;
+        io_writer_flush(w);
+        s += part;
+        len -= part;
+    }
+    memcpy(w->data + w->len, s, len);
+    w->len += len;
+}
+
+/**
+ * @brief appends the number in decimal, two digits are converted at once
+ * by the table of pairs, the digits are built from the end
+ * 
+ * @param w writer
+ * @param value number
+ */
+void io_write_int(io_writer_t *w, long long value) {
+    static const char pairs[201] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    char digits[24];
+    char *p = digits + sizeof(digits);
+    unsigned long long u = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+
+    while(u >= 100) {
+        p -= 2;
+        memcpy(p, pairs + 2 * (u % 100), 2);
+        u /= 100;
+    }
+    if(u >= 10) {
+        p -= 2;
+        memcpy(p, pairs + 2 * u, 2);
+    } else {
+        *--p = '0' + u;
+    }
+    if(value < 0) {
+        *--p = '-';
+    }
+    io_write(w, p, digits + sizeof(digits) - p);
+}
+
+/**
+ * @brief flushes the rest of the output and frees the buffer
+ * 
+ * @param w writer
+ * @return true if all the output was written
+ * @return false if some write failed
+ */
+bool io_writer_free(io_writer_t *w) {
+    bool ok = io_writer_flush(w);
+    free(w->data);
+    w->data = NULL;
+    if(!ok) {
+        fprintf(stderr, "Error: writing of the output.\n");
+    }
+    return ok;
+}
+
+// size of the queues of the pipeline, more than the blocks and the end mark,
+// so a push never has to wait
+#define IO_QUEUE_SIZE 8
+
+// bounded lock-free queue between two threads, one pushes and the other pops,
+// the positions only grow, each is written by one thread
+typedef struct io_queue {
+    _Alignas(64) atomic_size_t head;    // next item to pop
+    _Alignas(64) atomic_size_t tail;    // next free place
+    io_block_t *items[IO_QUEUE_SIZE];
+} io_queue_t;
+
+struct io_pipeline {
+    char *const *paths;
+    size_t n;
+    int max;
+    char *carry;            // start of the word cut by the end of a block
+    atomic_bool failed;     // set by both threads, read after they are joined
+    bool ended;             // the end mark was taken by the caller
+    pthread_t reader;
+    pthread_t tokenizer;
+    io_queue_t free;        // counter -> reader, empty blocks
+    io_queue_t full;        // reader -> tokenizer, read blocks
+    io_queue_t ready;       // tokenizer -> counter, tokenized blocks
+    io_block_t blocks[IO_PIPE_BLOCKS];
+};
+
+/**
+ * @brief waits for the other thread, yields the processor first and then sleeps,
+ * so the threads waiting for a slow disk do not take it from the others
+ * 
+ * @param spins number of the waits so far
+ */
+static void queue_wait(unsigned *spins) {
+    if((*spins)++ < 64) {
+        sched_yield();
+    } else {
+        nanosleep(&(struct timespec){ .tv_sec = 0, .tv_nsec = 50000 }, NULL);
+    }
+}
+
+/**
+ * @brief appends the block (or NULL as the end mark) to the queue
+ * 
+ * @param q queue
+ * @param b block
+ */
+static void queue_push(io_queue_t *q, io_block_t *b) {
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    unsigned spins = 0;
+    while(tail - atomic_load_explicit(&q->head, memory_order_acquire) == IO_QUEUE_SIZE) {
+        queue_wait(&spins);
+    }
+    q->items[tail % IO_QUEUE_SIZE] = b;
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+}
+
+/**
+ * @brief takes the first block of the queue, waits if it is empty
+ * 
+ * @param q queue
+ * @return io_block_t* block or NULL as the end mark
+ */
+static io_block_t *queue_pop(io_queue_t *q) {
+    size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    unsigned spins = 0;
+    while(atomic_load_explicit(&q->tail, memory_order_acquire) == head) {
+        queue_wait(&spins);
+    }
+    io_block_t *b = q->items[head % IO_QUEUE_SIZE];
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    return b;
+}
+
+/**
+ * @brief opens the file for the reader and asks the kernel to read it ahead
+ * 
+ * @param path file name
+ * @return int file descriptor or -1
+ */
+static int pipe_open(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        fprintf(stderr, "Failed to open file %s.\n", path);
+        return -1;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    return fd;
+}
+
+/**
+ * @brief reads the file to the blocks, every block ends at whitespace: the word at
+ * the end is carried to the next block. A word longer than max is carried only
+ * by its start and the rest of it is skipped, it is cut anyway.
+ * 
+ * @param p pipeline
+ * @param fd file descriptor
+ * @param path file name for the error message
+ * @param spare block taken from the free queue but not sent yet, updated
+ */
+static void pipe_read_file(io_pipeline_t *p, int fd, const char *path, io_block_t **spare) {
+    size_t carry = 0;
+    bool skipping = false;
+    bool eof = false;
+    while(!eof) {
+        io_block_t *b = *spare != NULL ? *spare : queue_pop(&p->free);
+        *spare = NULL;
+        memcpy(b->data, p->carry, carry);
+        size_t len = carry;
+
+        while(len < IO_PIPE_BLOCK && !eof) {
+            ssize_t count = read(fd, b->data + len, IO_PIPE_BLOCK - len);
+            if(count < 0 && errno == EINTR) {
+                continue;
+            }
+            if(count <= 0) {
+                if(count < 0) {
+                    fprintf(stderr, "Failed to read file %s.\n", path);
+                    atomic_store_explicit(&p->failed, true, memory_order_relaxed);
+                }
+                eof = true;
+                break;
+            }
+
+            char *start = b->data + len;
+            size_t rest = count;
+            if(skipping) {
+                // the rest of a long word
+                size_t word = 0;
+                while(word < rest && !isspace((unsigned char)start[word])) {
+                    word++;
+                }
+                skipping = word == rest;
+                memmove(start, start + word, rest - word);
+                rest -= word;
+            }
+            len += rest;
+        }
+
+        // the unfinished word goes to the next block
+        carry = 0;
+        if(!eof) {
+            size_t word = 0;
+            while(word < len && !isspace((unsigned char)b->data[len - 1 - word])) {
+                word++;
+            }
+            len -= word;
+            carry = word;
+            if(carry >= (size_t)p->max) {
+                carry = p->max;
+                skipping = true;
+            }
+            memcpy(p->carry, b->data + len, carry);
+        }
+
+        if(len > 0) {
+            b->len = len;
+            queue_push(&p->full, b);
+        } else {
+            *spare = b;
+        }
+    }
+}
+
+/**
+ * @brief reader stage: reads the files one by one, the next file is opened ahead,
+ * so its readahead runs while the current one is read
+ * 
+ * @param data pipeline
+ * @return void* NULL
+ */
+static void *pipe_reader(void *data) {
+    io_pipeline_t *p = data;
+    io_block_t *spare = NULL;
+    int fd = p->n > 0 ? pipe_open(p->paths[0]) : -1;
+    for(size_t i = 0; i < p->n; i++) {
+        int next = i + 1 < p->n ? pipe_open(p->paths[i + 1]) : -1;
+        if(fd < 0) {
+            atomic_store_explicit(&p->failed, true, memory_order_relaxed);
+        } else {
+            pipe_read_file(p, fd, p->paths[i], &spare);
+            close(fd);
+        }
+        fd = next;
+    }
+    queue_push(&p->full, NULL);
+    return NULL;
+}
+
+/**
+ * @brief tokenizer stage: finds the words of the blocks, the arrays of the words
+ * grow with the blocks and are kept for the next use of the block
+ * 
+ * @param data pipeline
+ * @return void* NULL
+ */
+static void *pipe_tokenizer(void *data) {
+    io_pipeline_t *p = data;
+    io_block_t *b;
+    while((b = queue_pop(&p->full)) != NULL) {
+        const char *pos = b->data;
+        const char *end = b->data + b->len;
+        b->count = 0;
+        b->cut = false;
+        while(true) {
+            if(b->count == b->capacity) {
+                size_t capacity = b->capacity > 0 ? 2 * b->capacity : IO_PIPE_BLOCK / 16;
+                const char **words = realloc(b->words, capacity * sizeof(char*));
+                if(words != NULL) {
+                    b->words = words;
+                }
+                size_t *lens = realloc(b->lens, capacity * sizeof(size_t));
+                if(lens != NULL) {
+                    b->lens = lens;
+                }
+                if(words == NULL || lens == NULL) {
+                    fprintf(stderr, "Error: allocation of the words.\n");
+                    atomic_store_explicit(&p->failed, true, memory_order_relaxed);
+                    break;
+                }
+                b->capacity = capacity;
+            }
+            size_t count = io_scan_words(&pos, end, p->max, b->words + b->count, b->lens + b->count,
+                                         b->capacity - b->count, &b->cut);
+            if(count == 0) {
+                break;
+            }
+            b->count += count;
+        }
+        queue_push(&p->ready, b);
+    }
+    queue_push(&p->ready, NULL);
+    return NULL;
+}
+
+/**
+ * @brief starts reading the files
+ * 
+ * @param paths file names
+ * @param n number of the files
+ * @param max the words are cut to max-1 characters
+ * @return io_pipeline_t* pipeline or NULL if the allocation or the start of the threads failed
+ */
+io_pipeline_t *io_pipeline_start(char *const *paths, size_t n, int max) {
+    io_pipeline_t *p = calloc(1, sizeof(io_pipeline_t));
+    bool ok = p != NULL && (p->carry = malloc(max)) != NULL;
+    for(int i = 0; ok && i < IO_PIPE_BLOCKS; i++) {
+        ok = (p->blocks[i].data = malloc(IO_PIPE_BLOCK)) != NULL;
+    }
+    if(!ok) {
+        fprintf(stderr, "Error: allocation of the input blocks.\n");
+        for(int i = 0; p != NULL && i < IO_PIPE_BLOCKS; i++) {
+            free(p->blocks[i].data);
+        }
+        if(p != NULL) {
+            free(p->carry);
+        }
+        free(p);
+        return NULL;
+    }
+
+    p->paths = paths;
+    p->n = n;
+    p->max = max;
+    atomic_init(&p->free.head, 0);
+    atomic_init(&p->free.tail, 0);
+    atomic_init(&p->full.head, 0);
+    atomic_init(&p->full.tail, 0);
+    atomic_init(&p->ready.head, 0);
+    atomic_init(&p->ready.tail, 0);
+    for(int i = 0; i < IO_PIPE_BLOCKS; i++) {
+        queue_push(&p->free, &p->blocks[i]);
+    }
+
+    // the tokenizer starts first, so a failed start of the reader is just the end of the input
+    bool started = pthread_create(&p->tokenizer, NULL, pipe_tokenizer, p) == 0;
+    if(started && pthread_create(&p->reader, NULL, pipe_reader, p) != 0) {
+        queue_push(&p->full, NULL);
+        while(io_pipeline_next(p) != NULL) {}
+        pthread_join(p->tokenizer, NULL);
+        started = false;
+    }
+    if(!started) {
+        fprintf(stderr, "Error: start of the input threads.\n");
+        for(int i = 0; i < IO_PIPE_BLOCKS; i++) {
+            free(p->blocks[i].data);
+        }
+        free(p->carry);
+        free(p);
+        return NULL;
+    }
+    return p;
+}
+
+/**
+ * @brief waits for the next tokenized block
+ * 
+ * @param p pipeline
+ * @return io_block_t* block or NULL at the end of the files
+ */
+io_block_t *io_pipeline_next(io_pipeline_t *p) {
+    if(p->ended) {
+        return NULL;
+    }
+    io_block_t *b = queue_pop(&p->ready);
+    p->ended = b == NULL;
+    return b;
+}
+
+/**
+ * @brief returns the counted block to the reader
+ * 
+ * @param p pipeline
+ * @param b block from io_pipeline_next
+ */
+void io_pipeline_release(io_pipeline_t *p, io_block_t *b) {
+    queue_push(&p->free, b);
+}
+
+/**
+ * @brief drops the rest of the blocks, waits for the threads and frees the pipeline
+ * 
+ * @param p pipeline
+ * @return true if all the files were read
+ * @return false if some file could not be read or an allocation failed
+ */
+bool io_pipeline_finish(io_pipeline_t *p) {
+    io_block_t *b;
+    while((b = io_pipeline_next(p)) != NULL) {
+        io_pipeline_release(p, b);
+    }
+    pthread_join(p->tokenizer, NULL);
+    pthread_join(p->reader, NULL);
+
+    bool ok = !atomic_load_explicit(&p->failed, memory_order_relaxed);
+    for(int i = 0; i < IO_PIPE_BLOCKS; i++) {
+        free(p->blocks[i].data);
+        free(p->blocks[i].words);
+        free(p->blocks[i].lens);
+    }
+    free(p->carry);
+    free(p);
+    return ok;
+}
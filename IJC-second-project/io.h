@@ -17,4 +17,87 @@
 
 int read_word(char *s, int max, FILE *f);
 
+// size of the blocks read by io_reader_t
+#define IO_BLOCK (256 * 1024)
+
+// Block reader of words: the input is read in big blocks and whitespace is found
+// 16 bytes at once (SSE2), the words are returned as spans right into the block.
+// Words longer than max-1 characters are cut as by read_word.
+typedef struct io_reader {
+    FILE *f;
+    int max;        // the words are cut to max-1 characters
+    char *data;     // IO_BLOCK bytes of the input and spaces behind them
+    size_t pos;     // first byte not processed yet
+    size_t len;     // end of the data in the block
+    bool eof;       // nothing more to read from f
+    bool cut;       // some word returned by the last call was cut
+    char *word;     // copy of a cut word that continued in the next block
+} io_reader_t;
+
+bool io_reader_init(io_reader_t *r, FILE *f, int max);
+// stores up to n next words to words and lens, returns their number, 0 at the end.
+// The words are not null terminated and are valid until the next call.
+size_t io_read_words(io_reader_t *r, const char **words, size_t *lens, size_t n);
+void io_reader_free(io_reader_t *r);
+
+// the same for the input already in memory (e.g. mapped file): stores up to n next
+// words between *p and end, *p is moved behind them, nothing behind end is read.
+// Words are cut to max-1 characters, *cut is set if some of them was.
+size_t io_scan_words(const char **p, const char *end, int max, const char **words, size_t *lens, size_t n, bool *cut);
+
+// Pipeline reading words of files: a reader thread reads the files in blocks of
+// IO_PIPE_BLOCK (with readahead hints), a tokenizer thread finds the words in them
+// and the caller gets the tokenized blocks. The stages are connected by bounded
+// lock-free queues, so reading, splitting and counting overlap. A block ends at
+// whitespace and files are not joined, a word never continues in the next block.
+#define IO_PIPE_BLOCK (1024 * 1024)
+#define IO_PIPE_BLOCKS 4        // blocks in flight
+
+typedef struct io_block {
+    char *data;
+    size_t len;
+    const char **words;     // words of the block, cut to max-1 characters
+    size_t *lens;
+    size_t count;
+    size_t capacity;        // size of words and lens
+    bool cut;               // some word of the block was cut
+} io_block_t;
+
+typedef struct io_pipeline io_pipeline_t;
+
+io_pipeline_t *io_pipeline_start(char *const *paths, size_t n, int max);
+// next tokenized block, NULL at the end, it has to be returned by io_pipeline_release
+io_block_t *io_pipeline_next(io_pipeline_t *p);
+void io_pipeline_release(io_pipeline_t *p, io_block_t *b);
+// waits for the threads and frees the pipeline, the remaining blocks are dropped.
+// Returns false if some file could not be read or an allocation failed.
+bool io_pipeline_finish(io_pipeline_t *p);
+
+// size of the buffer of io_writer_t
+#define IO_WRITE_BLOCK (256 * 1024)
+
+// Buffered output straight to the file descriptor: no format strings and no stdio
+// locking, the buffer is passed to write() when it is full. After an error the output
+// is dropped and error stays set, io_writer_free reports it.
+typedef struct io_writer {
+    int fd;
+    char *data;     // IO_WRITE_BLOCK bytes
+    size_t len;     // bytes waiting in the buffer
+    bool error;     // write failed
+} io_writer_t;
+
+bool io_writer_init(io_writer_t *w, int fd);
+bool io_writer_flush(io_writer_t *w);
+void io_write(io_writer_t *w, const char *s, size_t len);
+void io_write_int(io_writer_t *w, long long value);     // decimal
+bool io_writer_free(io_writer_t *w);                    // flushes, false if some write failed
+
+// single character, the common case does not leave the caller
+static inline void io_write_char(io_writer_t *w, char c) {
+    if(w->len == IO_WRITE_BLOCK) {
+        io_writer_flush(w);
+    }
+    w->data[w->len++] = c;
+}
+
 #endif // IO_H__
\ No newline at end of file
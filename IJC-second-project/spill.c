@@ -0,0 +1,364 @@
+/* spill.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "spill.h"
+#include "io.h"
+
+// Record of a run: uint32_t length of the key, htab_value_t value, the key without '\0'.
+
+// position in one run during the merge
+typedef struct cursor {
+    FILE *f;
+    char *key;
+    size_t capacity;    // size of key
+    uint32_t len;
+    htab_value_t value;
+    bool failed;        // the run ended by an error, not at the end of a record
+} cursor_t;
+
+/**
+ * @brief sets up empty spilling
+ * 
+ * @param s spill
+ * @param budget bytes the table can take
+ */
+void spill_init(spill_t *s, size_t budget) {
+    s->budget = budget;
+    s->count = 0;
+}
+
+/**
+ * @brief creates a temporary file for a run, it is removed when it is closed
+ * 
+ * @param s spill, the run is added to it
+ * @return FILE* the run or NULL if it could not be created
+ */
+static FILE *run_create(spill_t *s) {
+    FILE *f = tmpfile();
+    char *buffer = malloc(SPILL_READ_BUFFER);
+    if(f == NULL || buffer == NULL) {
+        fprintf(stderr, "Error: creating of a temporary file.\n");
+        if(f != NULL) {
+            fclose(f);
+        }
+        free(buffer);
+        return NULL;
+    }
+    // the run is written by the writer to the descriptor and only read by stdio
+    setvbuf(f, buffer, _IOFBF, SPILL_READ_BUFFER);
+    s->runs[s->count] = f;
+    s->levels[s->count] = 0;
+    s->buffers[s->count++] = buffer;
+    return f;
+}
+
+/**
+ * @brief appends a record to the run
+ * 
+ * @param key key, does not have to be null terminated
+ * @param len length of the key
+ * @param value value
+ * @param ctx io_writer_t of the run
+ * @return true always, the errors are collected by the writer
+ */
+static bool run_write(const char *key, size_t len, htab_value_t value, void *ctx) {
+    io_writer_t *w = ctx;
+    uint32_t len32 = len;
+    io_write(w, (const char *)&len32, sizeof(len32));
+    io_write(w, (const char *)&value, sizeof(value));
+    io_write(w, key, len);
+    return true;
+}
+
+/**
+ * @brief moves the cursor to the next record of its run
+ * 
+ * @param c cursor
+ * @return true if there is a record
+ * @return false at the end of the run or if reading failed, then c->failed is set
+ */
+static bool cursor_next(cursor_t *c) {
+    if(fread(&c->len, sizeof(c->len), 1, c->f) != 1) {
+        if(ferror(c->f)) {
+            fprintf(stderr, "Error: reading of a temporary file.\n");
+            c->failed = true;
+        }
+        return false;
+    }
+    // an empty key still gets a buffer, so it is never NULL
+    if(c->len >= c->capacity) {
+        char *key = realloc(c->key, c->len + 1);
+        if(key == NULL) {
+            fprintf(stderr, "Error: allocation of a key of a run.\n");
+            c->failed = true;
+            return false;
+        }
+        c->key = key;
+        c->capacity = c->len + 1;
+    }
+    // the record was started, so its end is an error
+    if(fread(&c->value, sizeof(c->value), 1, c->f) != 1 || fread(c->key, 1, c->len, c->f) != c->len) {
+        fprintf(stderr, "Error: reading of a temporary file.\n");
+        c->failed = true;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief the order of the keys of the runs, the order of strcmp for the keys without '\0'
+ * 
+ * @param a first cursor
+ * @param b second cursor
+ * @return true if the key of a goes before the key of b
+ */
+static bool cursor_less(const cursor_t *a, const cursor_t *b) {
+    size_t len = a->len < b->len ? a->len : b->len;
+    int order = memcmp(a->key, b->key, len);
+    return order < 0 || (order == 0 && a->len < b->len);
+}
+
+/**
+ * @brief moves the cursor at position i down the min-heap
+ * 
+ * @param heap cursors
+ * @param n number of cursors in the heap
+ * @param i position
+ */
+static void heap_down(cursor_t **heap, size_t n, size_t i) {
+    cursor_t *moved = heap[i];
+    while(2 * i + 1 < n) {
+        size_t child = 2 * i + 1;
+        if(child + 1 < n && cursor_less(heap[child + 1], heap[child])) {
+            child++;
+        }
+        if(!cursor_less(heap[child], moved)) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = moved;
+}
+
+/**
+ * @brief k-way merge of the runs by a min-heap of their cursors, the record with the
+ * smallest key is taken until the key changes, so the counts of one key are summed
+ * 
+ * @param runs the runs
+ * @param n number of the runs
+ * @param emit gets the merged records
+ * @param ctx passed to emit
+ * @return true if all the records were merged
+ * @return false if reading or an allocation failed or emit returned false
+ */
+static bool merge_runs(FILE **runs, size_t n, spill_emit_t emit, void *ctx) {
+    cursor_t *cursors = calloc(n, sizeof(cursor_t));
+    cursor_t **heap = malloc(n * sizeof(cursor_t*));
+    bool ok = cursors != NULL && heap != NULL;
+    if(!ok) {
+        fprintf(stderr, "Error: allocation of the merge.\n");
+    }
+
+    size_t size = 0;
+    for(size_t i = 0; ok && i < n; i++) {
+        cursors[i].f = runs[i];
+        ok = fseek(runs[i], 0, SEEK_SET) == 0;
+        if(ok && cursor_next(&cursors[i])) {
+            heap[size++] = &cursors[i];
+        }
+        ok = ok && !cursors[i].failed;
+    }
+    for(size_t i = size / 2; ok && i-- > 0;) {
+        heap_down(heap, size, i);
+    }
+
+    char *key = NULL;
+    size_t capacity = 0;
+    while(ok && size > 0) {
+        // the key is copied, the cursor moves on before the sum is complete
+        cursor_t *top = heap[0];
+        if(top->len >= capacity) {
+            char *bigger = realloc(key, top->len + 1);
+            if(bigger == NULL) {
+                fprintf(stderr, "Error: allocation of a key of a run.\n");
+                ok = false;
+                break;
+            }
+            key = bigger;
+            capacity = top->len + 1;
+        }
+        uint32_t len = top->len;
+        memcpy(key, top->key, len);
+        htab_value_t value = 0;
+
+        while(size > 0 && heap[0]->len == len && memcmp(heap[0]->key, key, len) == 0) {
+            value += heap[0]->value;
+            if(!cursor_next(heap[0])) {
+                // the rest of a failed run would be missing in the sums
+                if(heap[0]->failed) {
+                    ok = false;
+                    break;
+                }
+                heap[0] = heap[--size];
+            }
+            if(size > 0) {
+                heap_down(heap, size, 0);
+            }
+        }
+        ok = ok && emit(key, len, value, ctx);
+    }
+
+    for(size_t i = 0; ok && i < n; i++) {
+        if(ferror(runs[i])) {
+            fprintf(stderr, "Error: reading of a temporary file.\n");
+            ok = false;
+        }
+    }
+    for(size_t i = 0; cursors != NULL && i < n; i++) {
+        free(cursors[i].key);
+    }
+    free(key);
+    free(cursors);
+    free(heap);
+    return ok;
+}
+
+/**
+ * @brief closes the runs from the position first
+ * 
+ * @param s spill
+ * @param first first closed run
+ */
+static void runs_close(spill_t *s, size_t first) {
+    for(size_t i = first; i < s->count; i++) {
+        fclose(s->runs[i]);
+        free(s->buffers[i]);
+    }
+    s->count = first;
+}
+
+/**
+ * @brief merges the last n runs to one run in their place
+ * 
+ * @param s spill
+ * @param n number of the merged runs
+ * @param level level of the merged run
+ * @return true if the runs were merged
+ * @return false if writing, reading or an allocation failed, the runs are lost then
+ */
+static bool runs_merge_last(spill_t *s, size_t n, unsigned level) {
+    size_t first = s->count - n;
+    FILE *merged = tmpfile();
+    char *buffer = malloc(SPILL_READ_BUFFER);
+    io_writer_t w;
+    bool ok = merged != NULL && buffer != NULL && io_writer_init(&w, fileno(merged));
+    if(ok) {
+        setvbuf(merged, buffer, _IOFBF, SPILL_READ_BUFFER);
+        ok = merge_runs(s->runs + first, n, run_write, &w);
+        ok = io_writer_free(&w) && ok;
+    }
+    runs_close(s, first);
+    if(!ok) {
+        fprintf(stderr, "Error: merging of the temporary files.\n");
+        if(merged != NULL) {
+            fclose(merged);
+        }
+        free(buffer);
+        return false;
+    }
+    s->runs[first] = merged;
+    s->buffers[first] = buffer;
+    s->levels[first] = level;
+    s->count = first + 1;
+    return true;
+}
+
+/**
+ * @brief writes the records of the table sorted by key to a new run and clears the table.
+ * Then SPILL_MERGE_WAYS runs of the same level are merged to one run of the next level,
+ * the levels never grow towards the end, so the runs of one level are always the last ones.
+ * 
+ * @param s spill
+ * @param t hash table
+ * @return true if the run was written
+ * @return false if writing or an allocation failed
+ */
+bool spill_table(spill_t *s, htab_t *t) {
+    // all the levels are full, the last runs are merged without going up a level
+    if(s->count == SPILL_MAX_RUNS && !runs_merge_last(s, SPILL_MERGE_WAYS, s->levels[s->count - SPILL_MERGE_WAYS])) {
+        return false;
+    }
+
+    size_t n = htab_size(t);
+    htab_pair_t **pairs = malloc((n > 0 ? n : 1) * sizeof(htab_pair_t*));
+    if(pairs == NULL) {
+        fprintf(stderr, "Error: allocation of the spilled records.\n");
+        return false;
+    }
+    htab_iter_t it;
+    htab_iter_begin(t, &it);
+    size_t count = htab_iter_next_batch(&it, pairs, n);
+
+    io_writer_t w;
+    bool ok = htab_sort(pairs, count, HTAB_ORDER_KEY) && run_create(s) != NULL;
+    if(ok && io_writer_init(&w, fileno(s->runs[s->count - 1]))) {
+        for(size_t i = 0; i < count; i++) {
+            run_write(pairs[i]->key, strlen(pairs[i]->key), pairs[i]->value, &w);
+        }
+        ok = io_writer_free(&w);
+    } else {
+        ok = false;
+    }
+    free(pairs);
+    htab_clear(t);
+
+    // the new run has level 0, the last runs have the same level only if all of them have it
+    while(ok && s->count >= SPILL_MERGE_WAYS
+            && s->levels[s->count - SPILL_MERGE_WAYS] == s->levels[s->count - 1]) {
+        ok = runs_merge_last(s, SPILL_MERGE_WAYS, s->levels[s->count - 1] + 1);
+    }
+    return ok;
+}
+
+/**
+ * @brief spills the table if it takes more than the budget
+ * 
+ * @param s spill
+ * @param t hash table
+ * @return true if the table fits or was spilled
+ * @return false if spilling failed
+ */
+bool spill_check(spill_t *s, htab_t *t) {
+    return htab_memory(t) <= s->budget || spill_table(s, t);
+}
+
+/**
+ * @brief merges all the runs
+ * 
+ * @param s spill
+ * @param emit gets the records in the order of the keys
+ * @param ctx passed to emit
+ * @return true if all the records were merged
+ * @return false if reading failed or emit returned false
+ */
+bool spill_merge(spill_t *s, spill_emit_t emit, void *ctx) {
+    return merge_runs(s->runs, s->count, emit, ctx);
+}
+
+/**
+ * @brief closes and removes the runs
+ * 
+ * @param s spill
+ */
+void spill_free(spill_t *s) {
+    runs_close(s, 0);
+}
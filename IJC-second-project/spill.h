@@ -0,0 +1,51 @@
+/* spill.h
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+#ifndef SPILL_H__ // prevent multiple includes
+#define SPILL_H__
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "htab.h"
+
+// most runs open at once, it bounds the open files and buffers
+#define SPILL_MAX_RUNS 128
+
+// tiered merging: so many runs of one level are merged to one run of the next level,
+// every record is rewritten once per level, log16 of the number of spills times.
+// 15 runs on each of 8 levels fit in SPILL_MAX_RUNS, that is 16^8 spills.
+#define SPILL_MERGE_WAYS 16
+
+// stdio buffer of a run read by the merge
+#define SPILL_READ_BUFFER (32 * 1024)
+
+// Counting in bounded memory: when the table takes more than the budget, its records
+// are sorted by key and written to a temporary file (run) and the table is cleared.
+// The runs are merged at the end, the counts of the same key are summed.
+// Keys are taken up to the first '\0', as they are printed.
+typedef struct spill {
+    size_t budget;          // bytes of the table
+    FILE *runs[SPILL_MAX_RUNS];
+    char *buffers[SPILL_MAX_RUNS];
+    unsigned levels[SPILL_MAX_RUNS];    // merge level of the run, the levels never grow towards the end
+    size_t count;           // number of runs
+} spill_t;
+
+// function the merged records are passed to, in the order of the keys
+typedef bool (*spill_emit_t)(const char *key, size_t len, htab_value_t value, void *ctx);
+
+void spill_init(spill_t *s, size_t budget);
+// spills the table if it takes more than the budget, false if writing failed
+bool spill_check(spill_t *s, htab_t *t);
+// writes the records of the table to a new run and clears it
+bool spill_table(spill_t *s, htab_t *t);
+// merges all the runs in the order of the keys, false if reading failed or emit returned false
+bool spill_merge(spill_t *s, spill_emit_t emit, void *ctx);
+void spill_free(spill_t *s);
+
+#endif // SPILL_H__
@@ -1,11 +1,15 @@
+#define _GNU_SOURCE // memrchr, pread, fseeko
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <ctype.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #define MAX_LINE_SIZE 2048
 #define DEFAULT_N_SIZE 10
+#define SCAN_BLOCK_SIZE 65536
 
 /**
  * @brief cyclic buffer structure, that stores N elements of lines, read index, write index,
@@ -219,6 +223,54 @@ void load_lines(char* dest, FILE *fp, cbuf *cb) {
     }
 }
 
+/**
+ * @brief if the stream is a regular file, it is read backward from the end in blocks
+ * until n newlines are found, and the stream is moved to the beginning of the last n lines.
+ * Only the printed part of the file is read then. Pipes and terminals are left as they are,
+ * their lines are streamed through the cyclic buffer.
+ * The lines in front of the printed ones are not read, so a too long line among them
+ * is not reported, the warning is printed only for the printed lines.
+ *
+ * @param fp stream
+ * @param n number of lines to print out
+ */
+void seek_last_lines(FILE *fp, int n) {
+    int fd = fileno(fp);
+    struct stat st;
+    off_t begin = ftello(fp); // the stream does not have to be at the beginning of the file
+    if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || begin < 0 || st.st_size <= begin) {
+        return;
+    }
+
+    char block[SCAN_BLOCK_SIZE];
+    off_t end = st.st_size;
+    bool last_block = true;
+    int found = 0;
+    while(end > begin) {
+        size_t len = end - begin < SCAN_BLOCK_SIZE ? (size_t)(end - begin) : SCAN_BLOCK_SIZE;
+        off_t offset = end - len;
+        if(pread(fd, block, len, offset) != (ssize_t)len) {
+            return; // the file is read forward from where it was
+        }
+
+        // the newline at the end of the file ends the last line, it does not start a new one
+        if(last_block && block[len-1] == '\n') {
+            len--;
+        }
+        last_block = false;
+
+        char *newline = block + len;
+        while((newline = memrchr(block, '\n', newline - block)) != NULL) {
+            if(++found == n) {
+                fseeko(fp, offset + (newline - block) + 1, SEEK_SET);
+                return;
+            }
+        }
+        end = offset;
+    }
+    // the file has at most n lines, all of them are printed
+}
+
 
 int main(int argc, char *argv[]) {
     FILE *fp = stdin; // default stream
@@ -236,6 +288,7 @@ int main(int argc, char *argv[]) {
 
     // load the lines from file or stdin to buffer
     char line[MAX_LINE_SIZE];
+    seek_last_lines(fp, size); // only the end of a regular file is read
     load_lines(line, fp, cb);
 
     // if 'size' is less than the number of lines in the buffer, print 'size' lines. otherwise print the maximum number of lines.
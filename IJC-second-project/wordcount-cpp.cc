@@ -3,13 +3,93 @@
 // Příklad použití STL kontejneru unordered_map<>
 // Program počítá četnost slov ve vstupním textu,
 // slovo je cokoli oddělené "bílým znakem"
+// Přepínač --fast: stejný výstup bez iostream a bez std::string pro každé slovo
 
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <unordered_map>
+#include <memory_resource>
+#include <vector>
+#include <cstdio>
+#include <cstring>
 
-int main() {
+namespace {
+
+// bílé znaky jako u cin >> word v locale "C"
+bool is_space(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// celý vstup najednou místo čtení po slovech
+std::vector<char> read_all(std::FILE *f) {
+    std::vector<char> data(1 << 20);
+    std::size_t len = 0;
+    std::size_t n;
+    while ((n = std::fread(data.data() + len, 1, data.size() - len, f)) > 0) {
+        len += n;
+        if (len == data.size())
+            data.resize(2 * data.size());
+    }
+    data.resize(len);
+    return data;
+}
+
+int fast_wordcount() {
+    std::vector<char> input = read_all(stdin);
+
+    // klíče jsou string_view do arény, vyhledává se přímo podle
+    // string_view slova ze vstupu a kopie vzniká jen pro nové slovo
+    std::pmr::monotonic_buffer_resource arena(1 << 16);
+    std::unordered_map<std::string_view, int> m;
+    m.reserve(input.size() / 32); // odhad počtu různých slov podle velikosti vstupu
+
+    const char *p = input.data();
+    const char *end = p + input.size();
+    while (p < end) {
+        while (p < end && is_space(*p))
+            p++;
+        const char *start = p;
+        while (p < end && !is_space(*p))
+            p++;
+        if (p == start)
+            break;
+
+        std::string_view word(start, p - start);
+        auto it = m.find(word);
+        if (it != m.end()) {
+            it->second++;
+        } else {
+            char *key = static_cast<char *>(arena.allocate(word.size(), 1));
+            std::memcpy(key, word.data(), word.size());
+            m.emplace(std::string_view(key, word.size()), 1);
+        }
+    }
+
+    // výstup do vlastního bufferu, po blocích přes fwrite
+    std::string out;
+    out.reserve(1 << 18);
+    char number[16];
+    for (auto &mi: m) {
+        out.append(mi.first);
+        out.push_back('\t');
+        out.append(number, std::snprintf(number, sizeof(number), "%d\n", mi.second));
+        if (out.size() >= (1 << 18) - 64) {
+            std::fwrite(out.data(), 1, out.size(), stdout);
+            out.clear();
+        }
+    }
+    std::fwrite(out.data(), 1, out.size(), stdout);
+    return std::fflush(stdout) == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
     using namespace std;
+    if (argc > 1 && string_view(argv[1]) == "--fast")
+        return fast_wordcount();
+
     unordered_map<string,int> m;  // asociativní pole
                     // mapuje klíč/string na hodnotu/int
     string word;
@@ -23,4 +103,4 @@ int main() {
         cout << mi.first << "\t" << mi.second << "\n";
         //      klíč/slovo          hodnota/počet
         // prvky kontejneru typu "map" jsou dvojice (klíč,hodnota)
-}
\ No newline at end of file
+}
@@ -6,11 +6,20 @@
  * Compiled: gcc (GCC) 10.5.0
 */
 
+#define _POSIX_C_SOURCE 200809L
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "htab.h"
+#include "htab_sketch.h"
 #include "io.h"
+#include "spill.h"
 
 // The hash table size should be a prime number to reduce collisions. 
 // Since we don't know the exact size of the input, we have to choose a size that
@@ -22,6 +31,68 @@
 // maximum length of read word
 #define MAX_LENGTH_WORD 256
 
+// number of words passed to the hash table at once
+#define WORD_BATCH 64
+
+// the longest n-gram
+#define MAX_NGRAM 16
+
+// the smallest memory budget, the table itself takes about 120 kB
+#define MIN_MEMORY (1024 * 1024)
+
+// the most threads of the parallel mode
+#define MAX_JOBS 256
+
+// piece of a stream that can not be mapped read at once by the parallel mode
+#define READ_BLOCK (1 << 20)
+
+// default error bounds of the approximate mode, the sketch takes about 600 kB
+#define APPROX_EPSILON 0.0001
+#define APPROX_DELTA 0.01
+#define APPROX_HLL_ERROR 0.01
+
+// options of the program
+typedef struct options {
+    size_t top;         // number of printed words, SIZE_MAX prints all of them
+    const char *load;   // snapshot to start with or NULL
+    const char *save;   // snapshot to store the counts to or NULL
+    bool approx;        // count in fixed memory, top is the number of heavy hitters
+    size_t jobs;        // number of counting threads, 0 counts serially
+    bool sorted;        // print the pairs in the order, not in the order of the table
+    htab_order_t order;
+    char **files;       // files to count instead of stdin
+    size_t file_count;
+    size_t memory;      // bytes the table can take before it is spilled to disk, 0 is unlimited
+    size_t ngram;       // number of words counted together, 1 counts single words
+    bool time;          // print the time of the phases to stderr
+    double epsilon;
+    double delta;
+    double hll_error;
+} options_t;
+
+// window of the last words of the n-gram mode
+typedef struct ngram {
+    size_t n;           // words of the n-gram
+    size_t seen;        // words seen so far, the newest is at (seen - 1) % n
+    char words[MAX_NGRAM][MAX_LENGTH_WORD];
+    size_t lens[MAX_NGRAM];
+    size_t hashes[MAX_NGRAM];
+} ngram_t;
+
+// where the words go in the serial mode
+typedef struct counter {
+    htab_t *table;
+    spill_t *spill;     // NULL if there is no memory budget
+    ngram_t *ngram;     // NULL if single words are counted
+    bool timed;         // the phases below are measured
+    double mark;        // end of the last measured part
+    double read_time;   // waiting for the words: reading and tokenizing
+    double count_time;  // hashing and adding to the table, spilling
+} counter_t;
+
+
+// standard output of the printed pairs, print_pair is passed to htab_for_each, so it can not take it
+static io_writer_t output;
 
 /**
  * @brief prints out pair of hash table in format "[key]    [value]"
@@ -29,37 +100,881 @@
  * @param data pair 
  */
 void print_pair(htab_pair_t *data) {
-    printf("%s\t%d\n", data->key, data->value);
+    io_write(&output, data->key, strlen(data->key));
+    io_write_char(&output, '\t');
+    io_write_int(&output, data->value);
+    io_write_char(&output, '\n');
 }
 
-int main() {
-    htab_t *table = htab_init(TABLE_SIZE);
+/**
+ * @brief prints out the merged record of the spilled runs in the format of print_pair
+ * 
+ * @param key key, not null terminated
+ * @param len length of the key
+ * @param value count
+ * @param ctx unused
+ * @return true always, the errors of the output are reported at its end
+ */
+bool print_record(const char *key, size_t len, htab_value_t value, void *ctx) {
+    (void)ctx;
+    io_write(&output, key, len);
+    io_write_char(&output, '\t');
+    io_write_int(&output, value);
+    io_write_char(&output, '\n');
+    return true;
+}
 
-    bool warning = false;
-    char string[MAX_LENGTH_WORD];
-    int length = 0;
+/**
+ * @brief check if the passed parameter is only digits
+ * 
+ * @param parameter string to check
+ * @return true if it is only digits
+ * @return false if some characters is not digit or the string is empty
+ */
+bool number_valid(const char *parameter) {
+    if(*parameter == '\0') {
+        return false;
+    }
+    for(size_t i = 0; parameter[i] != '\0'; i++) {
+        if(!isdigit((unsigned char)parameter[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief reads a positive decimal number of the option
+ * 
+ * @param argc number of arguments
+ * @param argv array of arguments
+ * @param i position of the option, moved to its value
+ * @param result where to store the number
+ * @return true if the number is valid
+ * @return false if it is missing or invalid
+ */
+bool parse_fraction(int argc, char *argv[], int *i, double *result) {
+    char *end = NULL;
+    if(*i+1 < argc) {
+        *result = strtod(argv[*i+1], &end);
+    }
+    if(end == NULL || end == argv[*i+1] || *end != '\0' || !(*result > 0 && *result < 1)) {
+        fprintf(stderr, "Option %s requires a number between 0 and 1.\n", argv[*i]);
+        return false;
+    }
+    (*i)++;
+    return true;
+}
+
+/**
+ * @brief reads a size in bytes of the option, with an optional suffix K, M or G
+ * 
+ * @param argc number of arguments
+ * @param argv array of arguments
+ * @param i position of the option, moved to its value
+ * @param result where to store the size
+ * @return true if the size is valid
+ * @return false if it is missing, invalid or smaller than MIN_MEMORY
+ */
+bool parse_size(int argc, char *argv[], int *i, size_t *result) {
+    char *end = NULL;
+    if(*i+1 < argc && isdigit((unsigned char)argv[*i+1][0])) {
+        *result = strtoull(argv[*i+1], &end, 10);
+        int shift = 0;
+        switch(toupper((unsigned char)*end)) {
+            case 'G': shift += 10; // fall through
+            case 'M': shift += 10; // fall through
+            case 'K': shift += 10; end++; break;
+        }
+        *result = *result <= (SIZE_MAX >> shift) ? *result << shift : SIZE_MAX;
+    }
+    if(end == NULL || *end != '\0' || *result < MIN_MEMORY) {
+        fprintf(stderr, "Option %s requires a size of at least 1M.\n", argv[*i]);
+        return false;
+    }
+    (*i)++;
+    return true;
+}
+
+/**
+ * @brief handle passed arguments of the program
+ *  --top K         print only K most frequent words, in descending order
+ *  --load FILE     start with the counts from the snapshot FILE
+ *  --save FILE     store the final counts to the snapshot FILE
+ *  --approx K      count in fixed memory and print K approximate heavy hitters
+ *  --epsilon E     overestimate of a count in the approximate mode, as a fraction of all words
+ *  --delta D       probability that the overestimate is exceeded
+ *  --hll-error R   relative error of the number of distinct words
+ *  -j N            count in N threads, the input is read to memory (a file is mapped)
+ *  --sort ORDER    print the pairs sorted by count (descending) or by key
+ *  --memory SIZE   keep the table under SIZE bytes (suffix K, M or G), the counts over it
+ *                  are spilled to temporary files and merged, the output is sorted by key
+ *  --ngram N       count the sequences of N words (joined by a space) instead of single words
+ *  --time          print the time of reading, counting and printing to stderr
+ *  FILE...         count the files instead of stdin, they have to follow the options
+ * 
+ * @param argc number of arguments
+ * @param argv array of arguments
+ * @param opts where to store the options, has to be filled with defaults
+ * @return true if the arguments are valid
+ * @return false if the arguments are invalid
+ */
+bool parser(int argc, char *argv[], options_t *opts) {
+    for(int i = 1; i < argc; i++) {
+        if(strcmp("--top", argv[i]) == 0 || strcmp("--approx", argv[i]) == 0) {
+            if(i+1 >= argc || !number_valid(argv[i+1])) {
+                fprintf(stderr, "Option %s requires a number.\n", argv[i]);
+                return false;
+            }
+            opts->top = strtoul(argv[i+1], NULL, 10);
+            opts->approx = opts->approx || argv[i][2] == 'a';
+            i++; // increment the i since we processed it
+        } else if(strcmp("--load", argv[i]) == 0 || strcmp("--save", argv[i]) == 0) {
+            if(i+1 >= argc) {
+                fprintf(stderr, "Option %s requires a file name.\n", argv[i]);
+                return false;
+            }
+            *(argv[i][2] == 'l' ? &opts->load : &opts->save) = argv[i+1];
+            i++;
+        } else if(strcmp("-j", argv[i]) == 0) {
+            if(i+1 >= argc || !number_valid(argv[i+1])
+               || (opts->jobs = strtoul(argv[i+1], NULL, 10)) < 1 || opts->jobs > MAX_JOBS) {
+                fprintf(stderr, "Option -j requires a number between 1 and %d.\n", MAX_JOBS);
+                return false;
+            }
+            i++;
+        } else if(strcmp("--sort", argv[i]) == 0) {
+            if(i+1 < argc && strcmp("count", argv[i+1]) == 0) {
+                opts->order = HTAB_ORDER_VALUE;
+            } else if(i+1 < argc && strcmp("key", argv[i+1]) == 0) {
+                opts->order = HTAB_ORDER_KEY;
+            } else {
+                fprintf(stderr, "Option --sort requires count or key.\n");
+                return false;
+            }
+            opts->sorted = true;
+            i++;
+        } else if(strcmp("--ngram", argv[i]) == 0) {
+            if(i+1 >= argc || !number_valid(argv[i+1])
+               || (opts->ngram = strtoul(argv[i+1], NULL, 10)) < 1 || opts->ngram > MAX_NGRAM) {
+                fprintf(stderr, "Option --ngram requires a number between 1 and %d.\n", MAX_NGRAM);
+                return false;
+            }
+            i++;
+        } else if(strcmp("--time", argv[i]) == 0) {
+            opts->time = true;
+        } else if(strcmp("--memory", argv[i]) == 0) {
+            if(!parse_size(argc, argv, &i, &opts->memory)) {
+                return false;
+            }
+        } else if(strcmp("--epsilon", argv[i]) == 0) {
+            if(!parse_fraction(argc, argv, &i, &opts->epsilon)) {
+                return false;
+            }
+        } else if(strcmp("--delta", argv[i]) == 0) {
+            if(!parse_fraction(argc, argv, &i, &opts->delta)) {
+                return false;
+            }
+        } else if(strcmp("--hll-error", argv[i]) == 0) {
+            if(!parse_fraction(argc, argv, &i, &opts->hll_error)) {
+                return false;
+            }
+        } else if(argv[i][0] != '-') {
+            // the rest of the arguments are the files
+            opts->files = &argv[i];
+            opts->file_count = argc - i;
+            break;
+        } else {
+            fprintf(stderr, "Unknown argument %s.\n", argv[i]);
+            return false;
+        }
+    }
+
+    if(opts->approx && (opts->load != NULL || opts->save != NULL)) {
+        fprintf(stderr, "Snapshots can not be used in the approximate mode.\n");
+        return false;
+    }
+    if(opts->jobs > 0 && (opts->approx || opts->load != NULL || opts->save != NULL)) {
+        fprintf(stderr, "Option -j can not be used with snapshots or in the approximate mode.\n");
+        return false;
+    }
+    if(opts->file_count > 0 && (opts->approx || opts->jobs > 0)) {
+        fprintf(stderr, "Files can not be counted with -j or in the approximate mode, use the standard input.\n");
+        return false;
+    }
+    if(opts->ngram > 1 && (opts->jobs > 0 || opts->approx)) {
+        fprintf(stderr, "Option --ngram can not be used with -j or in the approximate mode.\n");
+        return false;
+    }
+    if(opts->time && (opts->jobs > 0 || opts->approx)) {
+        fprintf(stderr, "Option --time can not be used with -j or in the approximate mode.\n");
+        return false;
+    }
+    if(opts->memory > 0) {
+        // the merged runs come in the order of the keys, nothing else is known before the end
+        if(opts->jobs > 0 || opts->approx || opts->load != NULL || opts->save != NULL
+           || opts->top != SIZE_MAX || (opts->sorted && opts->order != HTAB_ORDER_KEY)) {
+            fprintf(stderr, "Option --memory can be used only with --sort key and files.\n");
+            return false;
+        }
+        opts->sorted = true;
+        opts->order = HTAB_ORDER_KEY;
+    }
+    return true;
+}
+
+/**
+ * @brief prints the records of the tables: in their order, or only the top most frequent
+ * ones (the top of each table is found first, only those are sorted), or all of them sorted
+ * 
+ * @param tables hash tables, the partitions of the parallel mode or just one table
+ * @param n number of tables
+ * @param opts options of the program, top and the order are used
+ * @return true if the pairs were printed
+ * @return false if the allocation failed
+ */
+bool print_tables(htab_t *const *tables, size_t n, const options_t *opts) {
+    size_t top = opts->top;
+    if(top == SIZE_MAX && !opts->sorted) {
+        for(size_t i = 0; i < n; i++) {
+            htab_for_each(tables[i], &print_pair);
+        }
+        return true;
+    }
 
-    while((length = read_word(string, MAX_LENGTH_WORD, stdin)) != EOF) {
+    // we never need more space than the tables have records
+    size_t total = 0;
+    for(size_t i = 0; i < n; i++) {
+        size_t size = htab_size(tables[i]);
+        total += top < size ? top : size;
+    }
+    htab_pair_t **pairs = malloc((total > 0 ? total : 1) * sizeof(htab_pair_t*));
+    if(pairs == NULL) {
+        fprintf(stderr, "Error: allocation of the printed pairs.\n");
+        return false;
+    }
+
+    size_t count = 0;
+    for(size_t i = 0; i < n; i++) {
+        if(top != SIZE_MAX) {
+            count += htab_topk(tables[i], top, pairs + count);
+        } else {
+            htab_iter_t it;
+            htab_iter_begin(tables[i], &it);
+            size_t got;
+            while((got = htab_iter_next_batch(&it, pairs + count, total - count)) > 0) {
+                count += got;
+            }
+        }
+    }
+
+    // the tops of the tables are merged by the sort, the result can still be ordered by key
+    bool ok = true;
+    if(top != SIZE_MAX && n > 1) {
+        ok = htab_sort(pairs, count, HTAB_ORDER_VALUE);
+        count = count < top ? count : top;
+    }
+    if(ok && opts->sorted && (top == SIZE_MAX || opts->order != HTAB_ORDER_VALUE)) {
+        ok = htab_sort(pairs, count, opts->order);
+    }
+    for(size_t i = 0; ok && i < count; i++) {
+        print_pair(pairs[i]);
+    }
+
+    free(pairs);
+    return ok;
+}
+
+/**
+ * @brief monotonic time for the phases
+ * 
+ * @return double seconds
+ */
+double seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * @brief adds the time since the last mark to the phase, when the counter is timed
+ * 
+ * @param c counter
+ * @param phase time of the phase
+ */
+static inline void phase_mark(counter_t *c, double *phase) {
+    if(c->timed) {
+        double now = seconds();
+        *phase += now - c->mark;
+        c->mark = now;
+    }
+}
+
+/**
+ * @brief adds the word to the window of the last n words and counts the n-gram ending with it.
+ * The words are copied, the spans of the input are not valid long enough. The hash of
+ * every word is computed once, the hash of the n-gram is combined from them and
+ * the joined n-gram is built only when it is new in the table.
+ * 
+ * @param g window
+ * @param table hash table
+ * @param word word, not null terminated
+ * @param len its length, less than MAX_LENGTH_WORD
+ * @return true if the n-gram was counted or the window is not full yet
+ * @return false if the allocation of a record failed
+ */
+bool ngram_add(ngram_t *g, htab_t *table, const char *word, size_t len) {
+    size_t position = g->seen++ % g->n;
+    memcpy(g->words[position], word, len);
+    g->lens[position] = len;
+    g->hashes[position] = htab_hash_function_n(word, len);
+    if(g->seen < g->n) {
+        return true;
+    }
+
+    // the oldest word is the one behind the newest
+    const char *parts[MAX_NGRAM];
+    size_t lens[MAX_NGRAM];
+    size_t hash = 0;
+    for(size_t i = 0; i < g->n; i++) {
+        size_t j = (position + 1 + i) % g->n;
+        parts[i] = g->words[j];
+        lens[i] = g->lens[j];
+        hash = i == 0 ? g->hashes[j] : htab_hash_append(hash, ' ', g->hashes[j], lens[i]);
+    }
+    return htab_lookup_add_parts(table, hash, parts, lens, g->n, ' ') != NULL;
+}
+
+/**
+ * @brief counts the words, or the n-grams ending with them, and spills the table if it is over the budget
+ * 
+ * @param c where the words go
+ * @param words words, not null terminated
+ * @param lens their lengths
+ * @param count number of the words
+ * @return true if all of them were counted
+ * @return false if the allocation of a record or spilling failed
+ */
+bool add_words(counter_t *c, const char *const *words, const size_t *lens, size_t count) {
+    bool ok = true;
+    if(c->ngram == NULL) {
+        htab_pair_t *pairs[WORD_BATCH];
+        for(size_t i = 0; ok && i < count; i += WORD_BATCH) {
+            size_t n = count - i < WORD_BATCH ? count - i : WORD_BATCH;
+            ok = htab_lookup_add_batch(c->table, words + i, lens + i, n, pairs);
+        }
+    } else {
+        for(size_t i = 0; ok && i < count; i++) {
+            ok = ngram_add(c->ngram, c->table, words[i], lens[i]);
+        }
+    }
+    if(!ok) {
+        fprintf(stderr, "Error: new_item allocation.\n");
+    }
+    return ok && (c->spill == NULL || spill_check(c->spill, c->table));
+}
+
+/**
+ * @brief reads the words from the stream and counts them in the hash table.
+ * The words are taken in batches right from the input block, so the table can load their buckets at once.
+ * 
+ * @param c where the words go
+ * @param f stream
+ * @return true if all the words were counted
+ * @return false if the allocation of a record or spilling failed
+ */
+bool count_words(counter_t *c, FILE *f) {
+    const char *keys[WORD_BATCH];
+    size_t lens[WORD_BATCH];
+
+    io_reader_t reader;
+    if(!io_reader_init(&reader, f, MAX_LENGTH_WORD)) {
+        return false;
+    }
+
+    bool warning = false;
+    bool ok = true;
+    size_t count;
+    c->mark = c->timed ? seconds() : 0;
+    while(ok && (count = io_read_words(&reader, keys, lens, WORD_BATCH)) > 0) {
+        phase_mark(c, &c->read_time);
 
         // if a word is longer that MAX_LENGTH_WORD and a warning has not beed printed out yet,
         // we print it out and set flag so we dont print it out anymore.
-        if(length > MAX_LENGTH_WORD-1 && !warning) {
+        if(reader.cut && !warning) {
+            fprintf(stderr, "A word is longer than 255 characters, cutting.\n");
+            warning = true;
+        }
+
+        // add or increment value of records in the hash table
+        ok = add_words(c, keys, lens, count);
+        phase_mark(c, &c->count_time);
+    }
+    phase_mark(c, &c->read_time);
+
+    io_reader_free(&reader);
+    return ok;
+}
+
+/**
+ * @brief counts the words of the files. They are read and split to words by the threads
+ * of io_pipeline_t, so the waiting for the disk and the tokenizing overlap with the counting.
+ * An unreadable file is reported and skipped. The n-grams continue from one file to the next,
+ * as if the files were concatenated.
+ * 
+ * @param c where the words go
+ * @param paths file names
+ * @param n number of the files
+ * @param complete set to false if some file could not be read
+ * @return true if all the words were counted
+ * @return false if the allocation of a record or of the pipeline or spilling failed
+ */
+bool count_files(counter_t *c, char *const *paths, size_t n, bool *complete) {
+    io_pipeline_t *pipeline = io_pipeline_start(paths, n, MAX_LENGTH_WORD);
+    if(pipeline == NULL) {
+        return false;
+    }
+
+    bool warning = false;
+    bool ok = true;
+    io_block_t *block;
+    c->mark = c->timed ? seconds() : 0;
+    while(ok && (block = io_pipeline_next(pipeline)) != NULL) {
+        phase_mark(c, &c->read_time);
+        if(block->cut && !warning) {
             fprintf(stderr, "A word is longer than 255 characters, cutting.\n");
             warning = true;
         }
+        ok = add_words(c, block->words, block->lens, block->count);
+        io_pipeline_release(pipeline, block);
+        phase_mark(c, &c->count_time);
+    }
+    phase_mark(c, &c->read_time);
+
+    *complete = io_pipeline_finish(pipeline);
+    return ok;
+}
+
+/**
+ * @brief counts the words in fixed memory and prints the heavy hitters,
+ * the summary goes to stderr, so the output keeps the format of the exact mode
+ * 
+ * @param opts options of the program
+ * @param f stream
+ * @return true if the words were counted
+ * @return false if an allocation failed
+ */
+bool count_approx(const options_t *opts, FILE *f) {
+    htab_sketch_t *sketch = htab_sketch_init(opts->epsilon, opts->delta, opts->hll_error, opts->top);
+    htab_sketch_hitter_t *hitters = malloc((opts->top > 0 ? opts->top : 1) * sizeof(htab_sketch_hitter_t));
+    if(sketch == NULL || hitters == NULL) {
+        fprintf(stderr, "Error: allocation of the sketch.\n");
+        htab_sketch_free(sketch);
+        free(hitters);
+        return false;
+    }
+
+    io_reader_t reader;
+    if(!io_reader_init(&reader, f, MAX_LENGTH_WORD)) {
+        htab_sketch_free(sketch);
+        free(hitters);
+        return false;
+    }
+
+    const char *words[WORD_BATCH];
+    size_t lens[WORD_BATCH];
+    bool warning = false;
+    size_t count;
+    while((count = io_read_words(&reader, words, lens, WORD_BATCH)) > 0) {
+        if(reader.cut && !warning) {
+            fprintf(stderr, "A word is longer than 255 characters, cutting.\n");
+            warning = true;
+        }
+        for(size_t i = 0; i < count; i++) {
+            if(!htab_sketch_add(sketch, words[i], lens[i])) {
+                fprintf(stderr, "Error: new_item allocation.\n");
+                io_reader_free(&reader);
+                htab_sketch_free(sketch);
+                free(hitters);
+                return false;
+            }
+        }
+    }
+    io_reader_free(&reader);
+
+    count = htab_sketch_top(sketch, hitters);
+    for(size_t i = 0; i < count; i++) {
+        printf("%s\t%llu\n", hitters[i].key, (unsigned long long)hitters[i].count);
+    }
+
+    uint64_t total = htab_sketch_total(sketch);
+    fprintf(stderr, "Approximate: %llu words, ~%.0f distinct, counts at most %.0f too high, %zu bytes.\n",
+            (unsigned long long)total, htab_sketch_distinct(sketch), opts->epsilon * total, htab_sketch_bytes(sketch));
+
+    htab_sketch_free(sketch);
+    free(hitters);
+    return true;
+}
+
+// whole input of the parallel mode
+typedef struct input {
+    char *data;
+    size_t len;
+    size_t mapped;      // length of the mapping, 0 if the data were read
+} input_t;
+
+// work of one thread: in the counting phase its part of the input, in the merging
+// phase its partition. tables[thread * jobs + partition] is the table of the thread
+// for the words whose hash falls into the partition.
+typedef struct job {
+    const char *from;
+    const char *to;
+    htab_t **tables;
+    size_t jobs;
+    size_t index;
+    bool ok;
+    bool cut;           // some word was longer than MAX_LENGTH_WORD
+} job_t;
+
+// words of one partition waiting to be added to its table
+typedef struct pending {
+    const char *keys[WORD_BATCH];
+    size_t lens[WORD_BATCH];
+    size_t count;
+} pending_t;
+
+/**
+ * @brief gets the whole stream to memory, a regular file is mapped,
+ * anything else (pipe, terminal) is read in blocks of READ_BLOCK
+ * 
+ * @param in where to store the input
+ * @param f stream
+ * @return true if the input is in memory
+ * @return false if reading or an allocation failed
+ */
+bool input_load(input_t *in, FILE *f) {
+    in->data = NULL;
+    in->len = in->mapped = 0;
+
+    int fd = fileno(f);
+    struct stat st;
+    off_t pos = lseek(fd, 0, SEEK_CUR);
+    if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && pos >= 0 && st.st_size > pos) {
+        void *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(base != MAP_FAILED) {
+            posix_madvise(base, st.st_size, POSIX_MADV_SEQUENTIAL);
+            in->data = (char *)base + pos;
+            in->len = st.st_size - pos;
+            in->mapped = st.st_size;
+            return true;
+        }
+    }
+
+    size_t capacity = 0;
+    size_t count;
+    do {
+        if(capacity - in->len < READ_BLOCK) {
+            capacity = capacity > 0 ? 2 * capacity : 4 * READ_BLOCK;
+            char *data = realloc(in->data, capacity);
+            if(data == NULL) {
+                fprintf(stderr, "Error: allocation of the input.\n");
+                free(in->data);
+                return false;
+            }
+            in->data = data;
+        }
+        count = fread(in->data + in->len, 1, READ_BLOCK, f);
+        in->len += count;
+    } while(count == READ_BLOCK);
+
+    if(ferror(f)) {
+        fprintf(stderr, "Error: reading of the input.\n");
+        free(in->data);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief unmaps or frees the input
+ * 
+ * @param in input
+ */
+void input_free(input_t *in) {
+    if(in->mapped > 0) {
+        munmap(in->data - (in->mapped - in->len), in->mapped);
+    } else {
+        free(in->data);
+    }
+}
+
+/**
+ * @brief partition of the word, given by the top bits of the hash, so it does
+ * not follow the buckets of the tables, which use the remainder
+ * 
+ * @param hash hash of the word, 32 bits
+ * @param jobs number of partitions
+ * @return size_t partition
+ */
+static inline size_t partition_of(size_t hash, size_t jobs) {
+    return (size_t)(((uint64_t)(uint32_t)hash * jobs) >> 32);
+}
+
+/**
+ * @brief counting thread: splits its part of the input to words and counts each
+ * in the table of its partition, the words are gathered to batches per partition
+ * 
+ * @param data job_t
+ * @return void* NULL
+ */
+void *count_job(void *data) {
+    job_t *job = data;
+    htab_t **tables = job->tables + job->index * job->jobs;
+    pending_t *pending = calloc(job->jobs, sizeof(pending_t));
+    if(pending == NULL) {
+        return NULL;
+    }
+
+    const char *words[WORD_BATCH];
+    size_t lens[WORD_BATCH];
+    htab_pair_t *pairs[WORD_BATCH];
+    const char *p = job->from;
+    size_t count;
+    job->ok = true;
+    while(job->ok && (count = io_scan_words(&p, job->to, MAX_LENGTH_WORD, words, lens, WORD_BATCH, &job->cut)) > 0) {
+        for(size_t i = 0; job->ok && i < count; i++) {
+            size_t part = partition_of(htab_hash_function_n(words[i], lens[i]), job->jobs);
+            pending_t *batch = &pending[part];
+            batch->keys[batch->count] = words[i];
+            batch->lens[batch->count++] = lens[i];
+            if(batch->count == WORD_BATCH) {
+                job->ok = htab_lookup_add_batch(tables[part], batch->keys, batch->lens, WORD_BATCH, pairs);
+                batch->count = 0;
+            }
+        }
+    }
+
+    // the rest of the batches
+    for(size_t part = 0; job->ok && part < job->jobs; part++) {
+        job->ok = htab_lookup_add_batch(tables[part], pending[part].keys, pending[part].lens, pending[part].count, pairs);
+    }
+    free(pending);
+    return NULL;
+}
+
+/**
+ * @brief merging thread: adds the tables of the other threads for its partition
+ * to the table of the first thread and frees them
+ * 
+ * @param data job_t
+ * @return void* NULL
+ */
+void *merge_job(void *data) {
+    job_t *job = data;
+    htab_t *result = job->tables[job->index];
+    job->ok = true;
+    for(size_t thread = 1; thread < job->jobs; thread++) {
+        htab_t **table = &job->tables[thread * job->jobs + job->index];
+        job->ok = job->ok && htab_merge(result, *table);
+        htab_free(*table);
+        *table = NULL;
+    }
+    return NULL;
+}
+
+/**
+ * @brief runs the function in jobs threads, one for each job
+ * 
+ * @param jobs array of jobs, ok is set to false for the threads that failed to start
+ * @param n number of jobs
+ * @param f body of the threads
+ * @return true if all the jobs finished successfully
+ */
+bool run_jobs(job_t *jobs, size_t n, void *(*f)(void *)) {
+    pthread_t ids[MAX_JOBS];
+    bool started[MAX_JOBS];
+    for(size_t i = 0; i < n; i++) {
+        jobs[i].ok = false;
+        started[i] = pthread_create(&ids[i], NULL, f, &jobs[i]) == 0;
+    }
+
+    bool ok = true;
+    for(size_t i = 0; i < n; i++) {
+        if(started[i]) {
+            pthread_join(ids[i], NULL);
+        }
+        ok = ok && jobs[i].ok;
+    }
+    return ok;
+}
+
+/**
+ * @brief parallel mode: the input is split at whitespace to opts->jobs parts, each is counted
+ * by its own thread to tables partitioned by hash, then each partition is merged by its own thread.
+ * The counts are the same as in the serial mode, only the order of the output differs.
+ * 
+ * @param opts options of the program
+ * @param f stream
+ * @return true if the words were counted and printed
+ * @return false if something failed
+ */
+bool count_parallel(const options_t *opts, FILE *f) {
+    size_t jobs = opts->jobs;
+    input_t in;
+    if(!input_load(&in, f)) {
+        return false;
+    }
+
+    // every partition gets its share of the buckets of the serial table
+    size_t buckets = TABLE_SIZE / jobs | 1;
+    htab_t **tables = calloc(jobs * jobs, sizeof(htab_t*));
+    job_t *work = calloc(jobs, sizeof(job_t));
+    bool ok = tables != NULL && work != NULL;
+    if(!ok) {
+        fprintf(stderr, "Error: allocation of the threads.\n");
+    }
+    for(size_t i = 0; ok && i < jobs * jobs; i++) {
+        ok = (tables[i] = htab_init(buckets)) != NULL;
+    }
+
+    if(ok) {
+        // the parts end at whitespace, so no word is split between two threads
+        const char *start = in.data;
+        const char *end = in.data + in.len;
+        for(size_t i = 0; i < jobs; i++) {
+            const char *stop = in.data + in.len * (i + 1) / jobs;
+            stop = stop > start ? stop : start;
+            while(stop < end && !isspace((unsigned char)*stop)) {
+                stop++;
+            }
+            work[i] = (job_t){ .from = start, .to = stop, .tables = tables, .jobs = jobs, .index = i };
+            start = stop;
+        }
 
-        // add or increment value of record in the hash table
-        htab_pair_t *new_item = htab_lookup_add(table, string);
-        (void)new_item;
-        if(new_item == NULL) {
+        ok = run_jobs(work, jobs, count_job);
+        for(size_t i = 0; i < jobs; i++) {
+            if(work[i].cut) {
+                fprintf(stderr, "A word is longer than 255 characters, cutting.\n");
+                break;
+            }
+        }
+        if(!ok) {
             fprintf(stderr, "Error: new_item allocation.\n");
-            htab_free(table);
-            return 1;
         }
     }
+    ok = ok && run_jobs(work, jobs, merge_job);
+
+    // the partitions are the tables of the first thread
+    ok = ok && print_tables(tables, jobs, opts);
+
+    #ifdef STATISTICS
+        for(size_t i = 0; ok && i < jobs; i++) {
+            htab_statistics(tables[i]);
+        }
+    #endif
 
-    // print out each pair
-    htab_for_each(table, &print_pair);
+    for(size_t i = 0; tables != NULL && i < jobs * jobs; i++) {
+        if(tables[i] != NULL) {
+            htab_free(tables[i]);
+        }
+    }
+    free(tables);
+    free(work);
+    input_free(&in);
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    options_t opts = {
+        .top = SIZE_MAX, // print all the pairs by default
+        .load = NULL,
+        .save = NULL,
+        .approx = false,
+        .jobs = 0,
+        .sorted = false,
+        .order = HTAB_ORDER_VALUE,
+        .files = NULL,
+        .file_count = 0,
+        .memory = 0,
+        .ngram = 1,
+        .time = false,
+        .epsilon = APPROX_EPSILON,
+        .delta = APPROX_DELTA,
+        .hll_error = APPROX_HLL_ERROR,
+    };
+    if(!parser(argc, argv, &opts)) {
+        return 1;
+    }
+
+    if(opts.approx) {
+        return count_approx(&opts, stdin) ? 0 : 1;
+    }
+    if(!io_writer_init(&output, STDOUT_FILENO)) {
+        return 1;
+    }
+    if(opts.jobs > 0) {
+        bool ok = count_parallel(&opts, stdin);
+        return io_writer_free(&output) && ok ? 0 : 1;
+    }
+    const char *load = opts.load;
+    const char *save = opts.save;
+
+    // the snapshot is only mapped, it is converted when the first word is added
+    htab_t *table = load != NULL ? htab_load(load) : htab_init(TABLE_SIZE);
+    if(table == NULL) {
+        io_writer_free(&output);
+        return 1;
+    }
+
+    // if the program was compiled with -DSTATISTICS, we count the operations too
+    #ifdef STATISTICS
+        htab_stats_enable(table, true);
+    #endif
+
+    spill_t spill;
+    spill_init(&spill, opts.memory);
+    ngram_t ngram = { .n = opts.ngram, .seen = 0 };
+    counter_t counter = {
+        .table = table,
+        .spill = opts.memory > 0 ? &spill : NULL,
+        .ngram = opts.ngram > 1 ? &ngram : NULL,
+        .timed = opts.time,
+        .read_time = 0,
+        .count_time = 0,
+    };
+
+    bool complete = true;
+    bool counted = opts.file_count > 0 ? count_files(&counter, opts.files, opts.file_count, &complete)
+                                       : count_words(&counter, stdin);
+    if(!counted) {
+        spill_free(&spill);
+        htab_free(table);
+        io_writer_free(&output);
+        return 1;
+    }
+
+    if(save != NULL && !htab_save(table, save)) {
+        htab_free(table);
+        io_writer_free(&output);
+        return 1;
+    }
+
+    // print out each pair, or only the most frequent ones, or all of them sorted.
+    // If some part was spilled, the rest follows and the runs are merged.
+    double output_start = seconds();
+    bool ok;
+    if(spill.count > 0) {
+        ok = spill_table(&spill, table) && spill_merge(&spill, print_record, NULL);
+    } else {
+        ok = print_tables(&table, 1, &opts);
+    }
+    spill_free(&spill);
+    ok = io_writer_free(&output) && ok;
+
+    if(opts.time) {
+        fprintf(stderr, "Time: read %.6f s, count %.6f s, output %.6f s.\n",
+                counter.read_time, counter.count_time, seconds() - output_start);
+    }
 
     // if the program was compiled with -DSTATISTICS, we print out statistics
     #ifdef STATISTICS
@@ -70,5 +985,5 @@ int main() {
     htab_free(table);
     table=NULL;
 
-    return 0;
+    return ok && complete ? 0 : 1;
 } //main
@@ -0,0 +1,347 @@
+/* wordcount_bench.c
+ * Solution IJC-DU2, task b)
+ * Author: Adam Běhoun, FIT
+ * Date: 17.4.2024
+ * login: xbehoua00
+ * Compiled: gcc (GCC) 10.5.0
+*/
+
+// End-to-end benchmark of the wordcount builds: wordcount (libhtab.a), wordcount-dynamic
+// (libhtab.so), wordcount -j with all the processors and the C++ reference wordcount-cpp
+// (plain and --fast).
+// Corpora of the given number of words are generated for every vocabulary size and skew:
+// the k-th most frequent word has frequency 1/k^s (s = 0 is uniform). Every variant is run
+// once to warm up the page cache and then repeatedly, the median time is reported with
+// words per second and peak RSS. One more run with --time splits the time of the serial
+// builds into reading (with tokenizing), counting (hashing) and output.
+// Usage: ./wordcount-bench [words per corpus] [repetitions]
+
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#define DEFAULT_WORDS 2000000
+#define DEFAULT_REPETITIONS 3
+#define MAX_REPETITIONS 15
+#define WORDS_PER_LINE 12
+#define WORD_LENGTH 16      // the longest generated word and '\0'
+
+// one build or configuration to compare
+typedef struct variant {
+    const char *name;
+    const char *argv[6];    // program and its arguments
+    bool timed;             // understands --time
+} variant_t;
+
+// result of one run
+typedef struct run {
+    double seconds;
+    long rss_kb;
+    double read, count, output;     // phases, only with --time
+    bool phases;
+} run_t;
+
+/**
+ * @brief generator of the corpora, the same numbers in every run
+ *
+ * @param state state of the generator
+ * @return uint64_t next number
+ */
+static uint64_t splitmix(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief creates the vocabulary: the word of rank i starts with i written in a fixed
+ * number of letters, so all the words differ, random letters make the lengths vary
+ *
+ * @param vocabulary number of words
+ * @param state state of the generator
+ * @return char (*)[WORD_LENGTH] the words or NULL if the allocation failed
+ */
+static char (*make_words(size_t vocabulary, uint64_t *state))[WORD_LENGTH] {
+    char (*words)[WORD_LENGTH] = malloc(vocabulary * sizeof(words[0]));
+    if(words == NULL) {
+        return NULL;
+    }
+
+    size_t digits = 1;
+    for(size_t v = 26; v < vocabulary; v *= 26) {
+        digits++;
+    }
+    for(size_t i = 0; i < vocabulary; i++) {
+        size_t len = digits + splitmix(state) % (WORD_LENGTH - 1 - digits);
+        size_t rank = i;
+        for(size_t d = 0; d < digits; d++) {
+            words[i][d] = 'a' + rank % 26;
+            rank /= 26;
+        }
+        for(size_t d = digits; d < len; d++) {
+            words[i][d] = 'a' + splitmix(state) % 26;
+        }
+        words[i][len] = '\0';
+    }
+    return words;
+}
+
+/**
+ * @brief writes the corpus
+ *
+ * @param f where to write
+ * @param count number of words
+ * @param vocabulary number of distinct words
+ * @param skew exponent of the Zipf distribution, 0 for uniform
+ * @return true if the corpus was written
+ */
+static bool write_corpus(FILE *f, size_t count, size_t vocabulary, double skew) {
+    uint64_t state = 42;
+    char (*words)[WORD_LENGTH] = make_words(vocabulary, &state);
+    double *cdf = malloc(vocabulary * sizeof(double));
+    if(words == NULL || cdf == NULL) {
+        free(words);
+        free(cdf);
+        return false;
+    }
+
+    double sum = 0;
+    for(size_t k = 0; k < vocabulary; k++) {
+        cdf[k] = sum += skew == 0 ? 1.0 : 1.0 / pow(k + 1, skew);
+    }
+    for(size_t i = 0; i < count; i++) {
+        // the rank is found by binary search of the cumulative distribution
+        double u = (splitmix(&state) >> 11) * 0x1.0p-53 * sum;
+        size_t low = 0, high = vocabulary - 1;
+        while(low < high) {
+            size_t middle = (low + high) / 2;
+            if(cdf[middle] < u) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        fputs(words[low], f);
+        putc((i + 1) % WORDS_PER_LINE == 0 ? '\n' : ' ', f);
+    }
+    free(words);
+    free(cdf);
+    return fflush(f) == 0;
+}
+
+/**
+ * @brief creates the corpus in a temporary file, it is generated by a child process,
+ * the peak RSS survives fork and exec, so the benchmark itself has to stay small
+ *
+ * @param count number of words
+ * @param vocabulary number of distinct words
+ * @param skew exponent of the Zipf distribution, 0 for uniform
+ * @param bytes where to store the size of the corpus
+ * @return int file descriptor of the corpus or -1
+ */
+static int make_corpus(size_t count, size_t vocabulary, double skew, size_t *bytes) {
+    FILE *f = tmpfile();
+    if(f == NULL) {
+        fprintf(stderr, "Error: creating of the corpus.\n");
+        return -1;
+    }
+    fflush(stdout);
+    pid_t pid = fork();
+    if(pid == 0) {
+        _exit(write_corpus(f, count, vocabulary, skew) ? 0 : 1);
+    }
+    int status = 1;
+    if(pid > 0) {
+        waitpid(pid, &status, 0);
+    }
+
+    // the file has no name, it is removed with the last descriptor
+    int fd = dup(fileno(f));
+    fclose(f);
+    struct stat st;
+    if(pid < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0 || fd < 0 || fstat(fd, &st) != 0) {
+        fprintf(stderr, "Error: creating of the corpus.\n");
+        if(fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    *bytes = st.st_size;
+    return fd;
+}
+
+/**
+ * @brief runs the variant on the corpus, the output goes to /dev/null
+ * and stderr is read for the phases
+ *
+ * @param v variant
+ * @param corpus descriptor of the corpus
+ * @param timed run with --time
+ * @param result where to store the result
+ * @return true if the program ran and ended successfully
+ */
+static bool run_variant(const variant_t *v, int corpus, bool timed, run_t *result) {
+    const char *argv[8];
+    size_t argc = 0;
+    for(; v->argv[argc] != NULL; argc++) {
+        argv[argc] = v->argv[argc];
+    }
+    if(timed) {
+        argv[argc++] = "--time";
+    }
+    argv[argc] = NULL;
+
+    int errors[2];
+    if(pipe(errors) != 0) {
+        return false;
+    }
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pid_t pid = fork();
+    if(pid == 0) {
+        int null = open("/dev/null", O_WRONLY);
+        lseek(corpus, 0, SEEK_SET);
+        dup2(corpus, STDIN_FILENO);
+        dup2(null, STDOUT_FILENO);
+        dup2(errors[1], STDERR_FILENO);
+        close(errors[0]);
+        execv(argv[0], (char *const *)argv);
+        _exit(127);
+    }
+    close(errors[1]);
+    if(pid < 0) {
+        close(errors[0]);
+        return false;
+    }
+
+    char text[512];
+    size_t len = 0;
+    ssize_t count;
+    while((count = read(errors[0], text + len, sizeof(text) - 1 - len)) > 0) {
+        len += count;
+        len = len < sizeof(text) - 1 ? len : 0;     // only the end matters
+    }
+    text[len] = '\0';
+    close(errors[0]);
+
+    int status;
+    struct rusage usage;
+    wait4(pid, &status, 0, &usage);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    result->seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    result->rss_kb = usage.ru_maxrss;
+    const char *phases = strstr(text, "Time:");
+    result->phases = phases != NULL && sscanf(phases, "Time: read %lf s, count %lf s, output %lf s.",
+                                              &result->read, &result->count, &result->output) == 3;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/**
+ * @brief orders the runs by time
+ *
+ * @param a first run
+ * @param b second run
+ * @return int qsort order
+ */
+static int compare_runs(const void *a, const void *b) {
+    double x = ((const run_t *)a)->seconds;
+    double y = ((const run_t *)b)->seconds;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief runs and reports all the variants on one corpus
+ *
+ * @param variants variants
+ * @param n number of the variants
+ * @param words words of the corpus
+ * @param vocabulary distinct words
+ * @param skew Zipf exponent
+ * @param repetitions measured runs of every variant
+ * @return true if the corpus was created
+ */
+static bool bench_corpus(const variant_t *variants, size_t n, size_t words, size_t vocabulary,
+                         double skew, int repetitions) {
+    size_t bytes;
+    int corpus = make_corpus(words, vocabulary, skew, &bytes);
+    if(corpus < 0) {
+        return false;
+    }
+
+    printf("%zu words, vocabulary %zu, skew %.2f, %.1f MB\n", words, vocabulary, skew, bytes / 1e6);
+    printf("  %-14s %9s %10s %9s %9s %9s %9s\n", "variant", "median s", "Mwords/s", "RSS MB", "read s", "count s", "output s");
+    for(size_t i = 0; i < n; i++) {
+        const variant_t *v = &variants[i];
+        run_t runs[MAX_REPETITIONS];
+        run_t warmup;
+        bool ok = run_variant(v, corpus, false, &warmup);
+        for(int r = 0; ok && r < repetitions; r++) {
+            ok = run_variant(v, corpus, false, &runs[r]);
+        }
+        if(!ok) {
+            printf("  %-14s failed (is it built?)\n", v->name);
+            continue;
+        }
+        qsort(runs, repetitions, sizeof(run_t), compare_runs);
+        run_t *median = &runs[repetitions / 2];
+
+        // the phases are measured separately, the clock reads cost something
+        run_t timed;
+        printf("  %-14s %9.3f %10.2f %9.1f", v->name, median->seconds, words / median->seconds / 1e6,
+               median->rss_kb / 1024.0);
+        if(v->timed && run_variant(v, corpus, true, &timed) && timed.phases) {
+            printf(" %9.3f %9.3f %9.3f\n", timed.read, timed.count, timed.output);
+        } else {
+            printf(" %9s %9s %9s\n", "-", "-", "-");
+        }
+    }
+    printf("\n");
+    fflush(stdout);
+    close(corpus);
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    size_t words = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_WORDS;
+    int repetitions = argc > 2 ? atoi(argv[2]) : DEFAULT_REPETITIONS;
+    if(words == 0 || repetitions < 1 || repetitions > MAX_REPETITIONS) {
+        fprintf(stderr, "Usage: %s [words per corpus] [repetitions 1-%d]\n", argv[0], MAX_REPETITIONS);
+        return 1;
+    }
+
+    char jobs[16];
+    snprintf(jobs, sizeof(jobs), "%ld", sysconf(_SC_NPROCESSORS_ONLN));
+    const variant_t variants[] = {
+        { "static", { "./wordcount", NULL }, true },
+        { "dynamic", { "./wordcount-dynamic", NULL }, true },
+        { "static -j", { "./wordcount", "-j", jobs, NULL }, false },
+        { "c++", { "./wordcount-cpp", NULL }, false },
+        { "c++ --fast", { "./wordcount-cpp", "--fast", NULL }, false },
+    };
+    size_t n = sizeof(variants) / sizeof(variants[0]);
+
+    const size_t vocabularies[] = { 10000, 100000, 1000000 };
+    const double skews[] = { 1.0, 0.0 };
+    printf("wordcount builds, %d repetitions, -j %s\n\n", repetitions, jobs);
+    for(size_t s = 0; s < sizeof(skews) / sizeof(skews[0]); s++) {
+        for(size_t i = 0; i < sizeof(vocabularies) / sizeof(vocabularies[0]); i++) {
+            if(!bench_corpus(variants, n, words, vocabularies[i], skews[s], repetitions)) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}